@@ -747,6 +747,29 @@ selftest_log_skip_init_socket_common() {
     check_test 1
 }
 
+@test "selftest_logs --binary-log" {
+    declare -A yamldump
+    local binlog=`mktempfile binary-XXXXXX.log`
+    sandstone_selftest -e selftest_logs --binary-log=$binlog
+    [[ "$status" -eq 0 ]]
+    test_yaml_regexp "/tests/0/result" pass
+    test_yaml_absent "/tests/0/threads"
+
+    # the thread messages are in the binary log instead
+    python3 $BATS_TEST_COMMONDIR/../scripts/binlog2yaml.py $binlog > $BATS_TEST_TMPDIR/binlog.yaml
+    rm -- $binlog
+    eval "yamldump=($(python3 $BATS_TEST_COMMONDIR/dumpyaml.py < $BATS_TEST_TMPDIR/binlog.yaml))"
+    test_yaml_regexp "/tests/0/test" selftest_logs
+    test_yaml_regexp "/tests/0/result" pass
+    test_yaml_regexp "/tests/0/threads/0/thread" main
+    test_yaml_regexp "/tests/0/threads/0/messages" '.*init function.*'
+    for ((i = 1; i <= MAX_PROC; ++i)); do
+        test_yaml_numeric "/tests/0/threads/$i/thread" "value == $i - 1"
+        test_yaml_regexp "/tests/0/threads/$i/id" '\{.*\}'
+        test_yaml_regexp "/tests/0/threads/$i/messages" '.*W> This is a .*warning.*'
+    done
+}
+
 @test "selftest_logdata" {
     declare -A yamldump
     sandstone_selftest -e selftest_logdata
@@ -1354,6 +1377,7 @@ function selftest_logerror_common() {
             test_yaml_regexp "/tests/0/threads/$i/messages/0/data-miscompare/actual" "$dataregexp"
             test_yaml_regexp "/tests/0/threads/$i/messages/0/data-miscompare/expected" "$dataregexp"
             test_yaml_regexp "/tests/0/threads/$i/messages/0/data-miscompare/mask" '0x[0-9a-f]+'
+            test_yaml_regexp "/tests/0/threads/$i/messages/0/data-miscompare/mismatches/count" '[1-9][0-9]*'
             test_yaml_regexp "/tests/0/threads/$i/messages/0/data-miscompare/actual data" '[0-9a-f ]+'
             test_yaml_regexp "/tests/0/threads/$i/messages/0/data-miscompare/expected data" '[0-9a-f ]+'
         done
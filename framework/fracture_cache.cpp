@@ -0,0 +1,85 @@
+/*
+ * Copyright 2025 Intel Corporation.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "fracture_cache.h"
+
+#include <stdio.h>
+
+#include <fstream>
+#include <sstream>
+
+static constexpr char Header[] = "# opendcdiag fracture cache v1";
+
+std::string FractureCache::make_key(std::string_view test_id) const
+{
+    std::string key = cpu_key;
+    key += ' ';
+    key += test_id;
+    return key;
+}
+
+void FractureCache::load()
+{
+    std::ifstream file(path, std::ios_base::in);
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        std::istringstream fields(line);
+        std::string cpu, id;
+        Entry entry;
+        if (!(fields >> cpu >> id >> entry.loop_count >> entry.ns_per_loop))
+            continue;
+        if (entry.loop_count <= 0)
+            continue;
+        entries[cpu + ' ' + id] = entry;
+    }
+    dirty = false;
+}
+
+bool FractureCache::save()
+{
+    if (!dirty)
+        return true;
+
+    // write to a temporary and rename, so a concurrent reader or a crash
+    // never sees a partial file
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream file(tmp, std::ios_base::out | std::ios_base::trunc);
+        file << Header << '\n';
+        for (const auto &[key, entry] : entries)
+            file << key << ' ' << entry.loop_count << ' ' << entry.ns_per_loop << '\n';
+        file.flush();
+        if (!file) {
+            remove(tmp.c_str());
+            return false;
+        }
+    }
+    if (rename(tmp.c_str(), path.c_str()) != 0) {
+        remove(tmp.c_str());
+        return false;
+    }
+    dirty = false;
+    return true;
+}
+
+const FractureCache::Entry *FractureCache::find(std::string_view test_id) const
+{
+    auto it = entries.find(make_key(test_id));
+    if (it == entries.end())
+        return nullptr;
+    return &it->second;
+}
+
+void FractureCache::update(std::string_view test_id, Entry entry)
+{
+    Entry &e = entries[make_key(test_id)];
+    if (e.loop_count == entry.loop_count && e.ns_per_loop == entry.ns_per_loop)
+        return;
+    e = entry;
+    dirty = true;
+}
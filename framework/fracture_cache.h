@@ -0,0 +1,61 @@
+/*
+ * Copyright 2025 Intel Corporation.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef SANDSTONE_FRACTURE_CACHE_H
+#define SANDSTONE_FRACTURE_CACHE_H
+
+#include <stdint.h>
+
+#include <map>
+#include <string>
+#include <string_view>
+
+/*
+ * On-disk record of how each test behaved on this kind of CPU in previous
+ * runs, so the automatic fracture sizing can size the first fracture from
+ * the last measured time per loop instead of re-learning it by doubling
+ * from 40.
+ *
+ * The file is plain text, one entry per line:
+ *
+ *      <cpu-key> <test-id> <loop-count> <ns-per-loop>
+ *
+ * Entries for other CPU keys are kept when the file is saved, so the same
+ * file can be shared by different machines.
+ */
+class FractureCache
+{
+public:
+    struct Entry
+    {
+        int loop_count = 0;             // fracture loop count the test converged on
+        uint64_t ns_per_loop = 0;       // average wall time of one loop iteration
+    };
+
+    FractureCache() = default;
+    FractureCache(std::string path, std::string cpu_key)
+        : path(std::move(path)), cpu_key(std::move(cpu_key))
+    {}
+
+    bool enabled() const
+    { return !path.empty(); }
+
+    // a missing file is not an error; malformed lines are ignored
+    void load();
+    bool save();
+
+    const Entry *find(std::string_view test_id) const;
+    void update(std::string_view test_id, Entry entry);
+
+private:
+    std::string path;
+    std::string cpu_key;
+    std::map<std::string, Entry, std::less<>> entries;      // keyed by "<cpu-key> <test-id>"
+    bool dirty = false;
+
+    std::string make_key(std::string_view test_id) const;
+};
+
+#endif // SANDSTONE_FRACTURE_CACHE_H
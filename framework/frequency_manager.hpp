@@ -8,11 +8,17 @@
 
 #include <sandstone_utils.h>
 
+#include <algorithm>
+#include <atomic>
 #include <string>
+#include <thread>
 #include <unordered_set>
 #include <vector>
 
+#include <fcntl.h>
 #include <stdint.h>
+#include <string.h>
+#include <unistd.h>
 
 #define BASE_CORE_FREQ_PATH    "/sys/devices/system/cpu/cpu"
 #define BASE_UNCORE_FREQ_PATH  "/sys/devices/system/cpu/intel_uncore_frequency/package_0"
@@ -24,12 +30,19 @@ class FrequencyManager
 private:
 
 #ifdef __linux__
+    // a sysfs file we keep open for the frequency changes
+    struct SysfsFile {
+        int fd = -1;
+        std::string path;
+    };
+
     // core-frequency variables
     int max_core_frequency_supported = 0;
     int min_core_frequency_supported = 0;
     std::vector<std::string> per_cpu_initial_scaling_governor;
     std::vector<std::string> per_cpu_initial_scaling_setspeed;
     int current_set_frequency = 0;
+    std::vector<SysfsFile> per_cpu_scaling_setspeed;
     std::vector<int> core_frequency_levels;
     int core_frequency_level_idx = 0;
     int total_core_frequency_levels = 0;
@@ -38,6 +51,7 @@ private:
     // uncore-frequency variables
     std::vector<std::pair<int, int>> initial_uncore_frequency;  // initial (min, max) un-core pair for each socket
     std::vector<std::vector<int>> uncore_frequency_levels;  // frequency levels for each socket
+    std::vector<std::pair<SysfsFile, SysfsFile>> uncore_frequency_files;   // (min, max) files for each socket
     uint16_t total_sockets = 0;
     int uncore_frequency_level_idx = 0;
     int total_uncore_frequency_levels = 0;
@@ -68,6 +82,64 @@ private:
         fprintf(file, "%s", line.data());
     }
 
+    SysfsFile open_sysfs_file(std::string path)
+    {
+        int fd = open(path.c_str(), O_WRONLY | O_CLOEXEC);
+        if (fd == -1) {
+            fprintf(stderr, "%s: cannot open file \"%s\" for writing. Make sure the user is root: %m\n", program_invocation_name, path.c_str());
+            exit(EXIT_NOPERMISSION);
+        }
+        return { fd, std::move(path) };
+    }
+
+    static void close_sysfs_file(SysfsFile &file)
+    {
+        if (file.fd != -1)
+            close(file.fd);
+        file.fd = -1;
+    }
+
+    [[noreturn]] static void sysfs_write_failed(const SysfsFile &file, std::string_view line, int err)
+    {
+        fprintf(stderr, "%s: cannot write \"%.*s\" to file \"%s\": %s\n", program_invocation_name,
+                int(line.size()), line.data(), file.path.c_str(), strerror(err));
+        exit(EXIT_NOPERMISSION);
+    }
+
+    static void write_sysfs_file(const SysfsFile &file, std::string_view line)
+    {
+        if (pwrite(file.fd, line.data(), line.size(), 0) != ssize_t(line.size()))
+            sysfs_write_failed(file, line, errno);
+    }
+
+    // Writes the same line to all the files. On large systems, the writes are
+    // split among a few threads, so the CPUs change frequency closer together
+    // and we don't wait as long before starting the test.
+    static void write_sysfs_files(const std::vector<SysfsFile> &files, std::string_view line)
+    {
+        static constexpr size_t FilesPerThread = 32;
+        std::atomic<int> failed_idx = -1;
+        std::atomic<int> failed_errno = 0;
+        auto write_range = [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                if (pwrite(files[i].fd, line.data(), line.size(), 0) != ssize_t(line.size())) {
+                    failed_errno.store(errno, std::memory_order_relaxed);
+                    failed_idx.store(i, std::memory_order_relaxed);
+                }
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (size_t begin = FilesPerThread; begin < files.size(); begin += FilesPerThread)
+            threads.emplace_back(write_range, begin, std::min(begin + FilesPerThread, files.size()));
+        write_range(0, std::min(FilesPerThread, files.size()));
+        for (std::thread &t : threads)
+            t.join();
+
+        if (int idx = failed_idx.load(std::memory_order_relaxed); idx >= 0)
+            sysfs_write_failed(files[idx], line, failed_errno.load(std::memory_order_relaxed));
+    }
+
     int get_frequency_from_file(std::string_view file_path)
     {
         /* Read frequency value from file */
@@ -155,6 +227,20 @@ private:
 
 public:
     FrequencyManager() {}
+    FrequencyManager(const FrequencyManager &) = delete;
+    FrequencyManager &operator=(const FrequencyManager &) = delete;
+
+    ~FrequencyManager()
+    {
+#ifdef __linux__
+        for (SysfsFile &file : per_cpu_scaling_setspeed)
+            close_sysfs_file(file);
+        for (auto &[min_file, max_file] : uncore_frequency_files) {
+            close_sysfs_file(min_file);
+            close_sysfs_file(max_file);
+        }
+#endif
+    }
 
     void initial_core_frequency_setup()
     {
@@ -192,6 +278,9 @@ public:
 
             //change scaling_governor to userspace in order to set the cores to different frequencies
             write_file(scaling_governor_path, "userspace");
+
+            // and keep scaling_setspeed open for change_core_frequency()
+            per_cpu_scaling_setspeed.push_back(open_sysfs_file(std::move(initial_scaling_setspeed_frequency_path)));
         }
 #endif
     }
@@ -233,6 +322,8 @@ public:
 
             populate_frequency_levels(max_min_frequency, false, total_uncore_frequency_levels);
             initial_uncore_frequency.push_back(std::move(max_min_frequency));
+            uncore_frequency_files.emplace_back(open_sysfs_file(std::move(min_freq_file)),
+                                                open_sysfs_file(std::move(max_freq_file)));
         }
 #endif
     }
@@ -241,13 +332,17 @@ public:
     {
 #ifdef __linux__
         current_set_frequency = core_frequency_levels[core_frequency_level_idx++ % total_core_frequency_levels];
+        write_sysfs_files(per_cpu_scaling_setspeed, std::to_string(current_set_frequency));
+#endif
+    }
 
-        for (int cpu = 0; cpu < num_cpus(); cpu++) {
-            std::string scaling_setspeed = BASE_CORE_FREQ_PATH;
-            scaling_setspeed += std::to_string(cpu_info[cpu].cpu_number);
-            scaling_setspeed += SCALING_SETSPEED;
-            write_file(scaling_setspeed, std::to_string(current_set_frequency));
-        }
+    // in kHz, as last set by change_core_frequency()
+    int current_core_frequency() const
+    {
+#ifdef __linux__
+        return current_set_frequency;
+#else
+        return 0;
 #endif
     }
 
@@ -255,15 +350,16 @@ public:
     {
 #ifdef __linux__
         for (size_t socket = 0; socket < total_sockets; socket++) {
-            std::string uncore_frequency_path = BASE_UNCORE_FREQ_PATH;
-            uncore_frequency_path += std::to_string(socket);
-
-            std::string min_freq_file = uncore_frequency_path + "_die_00/min_freq_khz";
             std::string frequency_to_write = std::to_string(uncore_frequency_levels[socket][uncore_frequency_level_idx++ % total_uncore_frequency_levels]);
-            write_file(min_freq_file, frequency_to_write);
-
-            std::string max_freq_file = uncore_frequency_path + "_die_00/max_freq_khz";
-            write_file(max_freq_file, frequency_to_write);
+            const auto &[min_file, max_file] = uncore_frequency_files[socket];
+            if (pwrite(min_file.fd, frequency_to_write.data(), frequency_to_write.size(), 0) < 0) {
+                // the new minimum may be above the current maximum, so try
+                // setting the maximum first
+                write_sysfs_file(max_file, frequency_to_write);
+                write_sysfs_file(min_file, frequency_to_write);
+            } else {
+                write_sysfs_file(max_file, frequency_to_write);
+            }
         }
 #endif
     }
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2025 Intel Corporation.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "sandstone_p.h"
+#include <stdint.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define HUGE_PAGE_SIZE      (2 * 1024 * 1024)
+
+static size_t round_up_to_huge_page(size_t size)
+{
+    return (size + HUGE_PAGE_SIZE - 1) & ~(size_t)(HUGE_PAGE_SIZE - 1);
+}
+
+/* Fault the pages in now if we're running on a test thread, so they come
+ * from that thread's NUMA node (the default policy is first touch) and the
+ * test doesn't pay for the page faults in its main loop. */
+static bool should_populate(void)
+{
+    return thread_num >= 0;
+}
+
+#ifdef MADV_HUGEPAGE
+/* Maps a regular anonymous region aligned to the huge page size, so all of
+ * it can be backed by transparent huge pages. */
+static void *mmap_thp(size_t size)
+{
+    size_t len = size + HUGE_PAGE_SIZE;
+    uint8_t *ptr = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED)
+        return ptr;
+
+    uintptr_t aligned = ((uintptr_t)ptr + HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(HUGE_PAGE_SIZE - 1);
+    size_t head = aligned - (uintptr_t)ptr;
+    if (head)
+        munmap(ptr, head);
+    if (len - head - size)
+        munmap((void *)(aligned + size), len - head - size);
+
+    madvise((void *)aligned, size, MADV_HUGEPAGE);
+#  ifdef MADV_POPULATE_WRITE
+    if (should_populate())
+        madvise((void *)aligned, size, MADV_POPULATE_WRITE);
+#  endif
+    return (void *)aligned;
+}
+#else
+static void *mmap_thp(size_t size)
+{
+    return mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+}
+#endif
+
+void *hugepage_alloc(size_t size)
+{
+    void *base = MAP_FAILED;
+    size = round_up_to_huge_page(size);
+    if (size == 0)
+        return NULL;
+
+#ifdef MAP_HUGETLB
+    /* this fails if not enough pages are reserved in hugetlbfs */
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+#  ifdef MAP_POPULATE
+    if (should_populate())
+        flags |= MAP_POPULATE;
+#  endif
+    base = mmap(NULL, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+#endif
+    if (base == MAP_FAILED)
+        base = mmap_thp(size);
+    return base == MAP_FAILED ? NULL : base;
+}
+
+void hugepage_free(void *ptr, size_t size)
+{
+    if (ptr)
+        munmap(ptr, round_up_to_huge_page(size));
+}
+
+/* malloc.cpp overrides this on systems where we replace the allocator */
+__attribute__((weak)) void malloc_enable_huge_pages(void)
+{
+}
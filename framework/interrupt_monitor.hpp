@@ -18,16 +18,33 @@ class InterruptMonitor
         MCE,
         Thermal,
     };
+public:
+    struct InterruptCounts
+    {
+        std::vector<uint32_t> mce;
+        std::vector<uint32_t> thermal;
+    };
+
+private:
     static uint64_t get_total_interrupt_counts(InterruptType type)
     {
         std::vector<uint32_t> counts = get_interrupt_counts(type);
         return std::accumulate(counts.begin(), counts.end(), uint64_t(0));
     }
 
-    // in sysdeps, if any
-    static std::vector<uint32_t> get_interrupt_counts(InterruptType type);
+    static std::vector<uint32_t> get_interrupt_counts(InterruptType type)
+    {
+        InterruptCounts counts = get_all_interrupt_counts();
+        return type == MCE ? std::move(counts.mce) : std::move(counts.thermal);
+    }
+
+    // in sysdeps, if any; reads the MCE and thermal rows in one pass
+    static InterruptCounts get_all_interrupt_counts();
 
 public:
+    InterruptCounts sample_interrupt_counts() const
+    { return get_all_interrupt_counts(); }
+
     std::vector<uint32_t> get_mce_interrupt_counts() const
     { return get_interrupt_counts(MCE); }
 
@@ -54,7 +71,7 @@ public:
 };
 
 #if !defined(__linux__) || !defined(__x86_64__)
-inline std::vector<uint32_t> InterruptMonitor::get_interrupt_counts(InterruptType)
+inline InterruptMonitor::InterruptCounts InterruptMonitor::get_all_interrupt_counts()
 {
     static_assert(!InterruptMonitorWorks);
     return {};
@@ -7,6 +7,7 @@
 #ifdef _WIN32
 #  define _POSIX_C_SOURCE 200112L
 #endif
+#include "memcmp_mismatch.h"
 #include "sandstone.h"
 #include "sandstone_p.h"
 #include "sandstone_iovec.h"
@@ -39,6 +40,7 @@
 #include <unistd.h>
 
 #ifndef _WIN32
+#  include <signal.h>
 #  include <sys/utsname.h>
 #endif
 
@@ -99,6 +101,7 @@ static const char program_version[] = SANDSTONE_EXECUTABLE_NAME "-" GIT_ID;
 static int real_stdout_fd = STDOUT_FILENO;
 static int tty = -1;
 static int file_log_fd = -1;
+static int binary_log_fd = -1;
 static int stderr_fd = -1;
 static bool delete_log_on_success;
 static uint8_t progress_bar_needs_flush = false;
@@ -482,13 +485,105 @@ static const char *char_to_skip_category(int val)
     return "NO CATEGORY PRESENT";
 }
 
+// Each thread's messages are appended to a buffer in the shared memory,
+// which only that thread writes to. If it fills up, the contents are flushed
+// to the thread's log file and the LogBufferSpilled bit is set, so the
+// reader knows to get the messages from the file.
+static constexpr unsigned LogBufferSpilled = 1U << 31;
+static_assert(PerThreadData::LogBufferSize < LogBufferSpilled);
+
+static char *log_buffer(const PerThreadData::Common *data)
+{
+    return reinterpret_cast<char *>(sApp->shmem) + data->log_buffer_offset;
+}
+
+namespace {
+// Blocks all signals to the calling thread while in scope
+struct SignalBlocker
+{
+#ifndef _WIN32
+    sigset_t saved;
+    SignalBlocker()
+    {
+        sigset_t all;
+        sigfillset(&all);
+        pthread_sigmask(SIG_SETMASK, &all, &saved);
+    }
+    ~SignalBlocker()
+    {
+        pthread_sigmask(SIG_SETMASK, &saved, nullptr);
+    }
+#endif
+};
+} // unnamed namespace
+
+// Set while this thread copies a message into its reserved space
+static thread_local bool log_buffer_copying;
+
+// A signal handler on this thread (the MCE one, for example) may log a
+// message while we're in the middle of appending, so the space is reserved
+// with a compare-and-swap before copying: a nested append always lands
+// after ours.
+static ssize_t log_buffer_append(PerThreadData::Common *data, const struct iovec *vec, int count)
+{
+    size_t len = 0;
+    for (int i = 0; i < count; ++i)
+        len += vec[i].iov_len;
+
+    auto copy_to = [&](char *ptr) {
+        for (int i = 0; i < count; ++i) {
+            memcpy(ptr, vec[i].iov_base, vec[i].iov_len);
+            ptr += vec[i].iov_len;
+        }
+    };
+
+    unsigned cur = data->log_buffer_used.load(std::memory_order_relaxed);
+    for (;;) {
+        unsigned used = cur & ~LogBufferSpilled;
+        if (used + len > PerThreadData::LogBufferSize)
+            break;
+        unsigned next = (cur & LogBufferSpilled) | (used + len);
+        if (data->log_buffer_used.compare_exchange_weak(cur, next, std::memory_order_acquire,
+                                                        std::memory_order_relaxed)) {
+            log_buffer_copying = true;
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+            copy_to(log_buffer(data) + used);
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+            log_buffer_copying = false;
+            return len;
+        }
+    }
+
+    // doesn't fit, so flush what we have; no handler may append meanwhile
+    SignalBlocker blocker;
+    if (log_buffer_copying) {
+        // we interrupted an append whose message isn't complete yet, so
+        // leave the buffer alone and go straight to the file
+        data->log_buffer_used.fetch_or(LogBufferSpilled, std::memory_order_relaxed);
+        return writev(data->log_fd, vec, count);
+    }
+    unsigned used = data->log_buffer_used.load(std::memory_order_relaxed) & ~LogBufferSpilled;
+    IGNORE_RETVAL(write(data->log_fd, log_buffer(data), used));
+    if (len > PerThreadData::LogBufferSize) {
+        data->log_buffer_used.store(LogBufferSpilled, std::memory_order_release);
+        return writev(data->log_fd, vec, count);
+    }
+    copy_to(log_buffer(data));
+    data->log_buffer_used.store(LogBufferSpilled | len, std::memory_order_release);
+    return len;
+}
+
 template <typename... Args> static ssize_t
 log_message_for_thread(int thread_num, LogTypes logType, int level, Args &&... args)
 {
-    int fd = sApp->thread_data(thread_num)->log_fd;
+    static const char terminator = '\0';
+    PerThreadData::Common *data = sApp->thread_data(thread_num);
     uint8_t code = message_code(logType, level);
-    sApp->thread_data(thread_num)->messages_logged.fetch_add(1, std::memory_order_relaxed);
-    return writevec(fd, code, std::forward<Args>(args)..., '\0');
+    data->messages_logged.fetch_add(1, std::memory_order_relaxed);
+
+    IoVecMaker maker;
+    struct iovec vec[] = { maker(code), maker(args)..., maker(terminator) };
+    return log_buffer_append(data, vec, std::size(vec));
 }
 
 int logging_stdout_fd(void)
@@ -511,19 +606,38 @@ static inline void truncate_log(int fd)
     IGNORE_RETVAL(ftruncate(fd, 0));
 }
 
-static inline mmap_region maybe_mmap_log(const PerThreadData::Common *data)
+static inline mmap_region maybe_mmap_log(PerThreadData::Common *data)
 {
     if (data->messages_logged.load(std::memory_order_relaxed) == 0)
         return {};
+
+    unsigned used = data->log_buffer_used.load(std::memory_order_acquire);
+    if ((used & LogBufferSpilled) == 0)
+        return { log_buffer(data), used };
+
+    // append the rest of the messages to the file so they're contiguous
+    used &= ~LogBufferSpilled;
+    if (used)
+        IGNORE_RETVAL(write(data->log_fd, log_buffer(data), used));
+    data->log_buffer_used.store(LogBufferSpilled, std::memory_order_relaxed);
     return mmap_file(data->log_fd);
 }
 
+static inline void munmap_log(const PerThreadData::Common *data, mmap_region r)
+{
+    if (r.base != log_buffer(data))
+        munmap_file(r);
+}
+
 static inline void munmap_and_truncate_log(PerThreadData::Common *data, mmap_region r)
 {
     if (r.size == 0)
         return;
-    munmap_file(r);
-    truncate_log(data->log_fd);
+    if (r.base != log_buffer(data)) {
+        munmap_file(r);
+        truncate_log(data->log_fd);
+    }
+    data->log_buffer_used.store(0, std::memory_order_relaxed);
     data->messages_logged.store(0, std::memory_order_relaxed);
 }
 
@@ -645,6 +759,16 @@ void logging_init_global(void)
         }
     }
 
+    if (!sApp->binary_log_path.empty()
+            && current_output_format() == SandstoneApplication::OutputFormat::yaml) {
+        binary_log_fd = open(sApp->binary_log_path.c_str(), O_WRONLY | O_CLOEXEC | O_CREAT | O_TRUNC, 0666);
+        if (binary_log_fd == -1) {
+            fprintf(stderr, "%s: failed to open binary log file: %s: %s\n",
+                    program_invocation_name, sApp->binary_log_path.c_str(), strerror(errno));
+            exit(EX_CANTCREAT);
+        }
+    }
+
     if (file_log_fd == -1) {
         file_log_fd = real_stdout_fd;
     } else {
@@ -1281,9 +1405,29 @@ void log_data(const char *message, const void *data, size_t size)
     log_data_common(message, static_cast<const uint8_t *>(data), size, false);
 }
 
+// e.g. "{ count: 3, offsets: [ 4, 68, 132 ], bit-flips: { 0: 3, 9: 1 } }"
+static std::string format_mismatch_map(const MemcmpMismatchMap &mismatches)
+{
+    std::string result = stdprintf("{ count: %zu, offsets: [ ", mismatches.count);
+    for (int i = 0; i < mismatches.offset_count; ++i)
+        result += stdprintf("%s%td", i ? ", " : "", mismatches.offsets[i]);
+
+    result += " ], bit-flips: {";
+    bool first = true;
+    for (size_t bit = 0; bit < std::size(mismatches.bit_histogram); ++bit) {
+        if (uint32_t n = mismatches.bit_histogram[bit]) {
+            result += stdprintf("%s %zu: %u", first ? "" : ",", bit, n);
+            first = false;
+        }
+    }
+    result += first ? "} }" : " } }";
+    return result;
+}
+
 static void logging_format_data(DataType type, std::string_view description, const uint8_t *data1,
-                                const uint8_t *data2, ptrdiff_t offset)
+                                const uint8_t *data2, const MemcmpMismatchMap &mismatches)
 {
+    ptrdiff_t offset = mismatches.first_offset();
     std::string spaces(sApp->shmem->output_yaml_indent + 7, ' ');
     std::string buffer;
     switch (current_output_format()) {
@@ -1348,6 +1492,7 @@ static void logging_format_data(DataType type, std::string_view description, con
                             spaces.c_str(), format_single_type(type, typeSize, data1 + alignedOffset, true).c_str(),
                             spaces.c_str(), format_single_type(type, typeSize, data2 + alignedOffset, true).c_str(),
                             spaces.c_str(), format_single_type(type, typeSize, xormask, false).c_str());
+        buffer += stdprintf("%smismatches:  %s\n", spaces.c_str(), format_mismatch_map(mismatches).c_str());
     } else {
         // no difference was found: memcmp_offset() disagrees with memcmp_or_fail()
         buffer += stdprintf("%soffset:      null\n", spaces.c_str());
@@ -1355,7 +1500,7 @@ static void logging_format_data(DataType type, std::string_view description, con
         buffer += stdprintf("%sactual:      null\n"
                             "%sexpected:    null\n"
                             "%smask:        null\n"
-                            "%sremark:      'memcmp_offset() could not locate difference'\n",
+                            "%sremark:      'memcmp_mismatch_map() could not locate difference'\n",
                             spaces.c_str(), spaces.c_str(), spaces.c_str(), spaces.c_str());
     }
 
@@ -1363,8 +1508,9 @@ static void logging_format_data(DataType type, std::string_view description, con
 }
 
 void logging_report_mismatched_data(DataType type, const uint8_t *actual, const uint8_t *expected,
-                                    size_t size, ptrdiff_t offset, const char *fmt, va_list va)
+                                    size_t size, const MemcmpMismatchMap &mismatches, const char *fmt, va_list va)
 {
+    ptrdiff_t offset = mismatches.first_offset();
     logging_mark_thread_failed(thread_num);
     if (current_output_format() == SandstoneApplication::OutputFormat::no_output)
         return;
@@ -1376,7 +1522,7 @@ void logging_report_mismatched_data(DataType type, const uint8_t *actual, const
             description = vstdprintf(fmt, va);
 
         logging_format_data(type, escape_for_single_line(description, escaped_description),
-                            actual, expected, offset);
+                            actual, expected, mismatches);
     }
     if (offset < 0)
         return;         // we couldn't find a difference
@@ -1528,7 +1674,8 @@ void AbstractLogger::format_and_print_message(int fd, std::string_view message,
 static std::string get_skip_message(int thread_num)
 {
     std::string skip_message;
-    struct mmap_region r = mmap_file(sApp->thread_data(thread_num)->log_fd);
+    PerThreadData::Common *data = sApp->thread_data(thread_num);
+    struct mmap_region r = maybe_mmap_log(data);
     auto ptr = static_cast<const char *>(r.base);
     const char *end = ptr + r.size;
     const char *delim;
@@ -1540,7 +1687,7 @@ static std::string get_skip_message(int thread_num)
             break;
         }
     }
-    munmap_file(r);
+    munmap_log(data, r);
     return skip_message;
 }
 
@@ -2189,6 +2336,29 @@ void YamlLogger::print_thread_header(int fd, int cpu, int verbosity)
             const double effective_freq_mhz = thr->effective_freq_mhz;
             if (std::isfinite(effective_freq_mhz))
                 dprintf(fd, "%s    freq_mhz: %.1f\n", indent_spaces().data(), effective_freq_mhz);
+
+            const PerfCounterSet &counters = thr->perf_counters;
+            if (counters.values[PerfCounterSet::Cycles] != PerfCounterSet::NotAvailable) {
+                static constexpr const char *names[] = {
+                    "cycles", "instructions", "branch-misses", "l1d-misses", "llc-misses"
+                };
+                static_assert(std::size(names) == PerfCounterSet::CounterCount);
+                std::string line = "    perf-counters: { ";
+                for (int i = 0; i < PerfCounterSet::CounterCount; ++i) {
+                    uint64_t value = counters.values[i];
+                    if (value == PerfCounterSet::NotAvailable)
+                        continue;
+                    if (i)
+                        line += ", ";
+                    line += stdprintf("%s: %" PRIu64, names[i], value);
+                    if (i == PerfCounterSet::Instructions && counters.values[PerfCounterSet::Cycles])
+                        line += stdprintf(", ipc: %.2f", double(value) / counters.values[PerfCounterSet::Cycles]);
+                }
+                if (counters.multiplexed)
+                    line += ", multiplexed: true";
+                line += " }";
+                writeln(fd, indent_spaces(), line);
+            }
         }
     }
     writeln(fd, indent_spaces(), "    messages:");
@@ -2446,6 +2616,174 @@ std::string YamlLogger::get_current_time()
              iso8601_time_now(Iso8601Format::WithoutMs));
 }
 
+// The binary log (--binary-log) receives each thread's message buffer as-is,
+// prefixed by a fixed-size record header, so the parent doesn't spend time
+// rendering YAML between tests. scripts/binlog2yaml.py reads it back; keep
+// the two in sync.
+namespace BinaryLog {
+static constexpr char Magic[8] = { 'S', 'D', 'C', 'D', 'B', 'L', 'O', 'G' };
+static constexpr uint32_t Version = 1;
+
+enum RecordType : uint8_t {
+    TestRecord = 1,         // payload: test id and result, NUL-terminated
+    ThreadRecord = 2,       // payload: ThreadInfo, then the raw messages
+};
+
+struct FileHeader {
+    char magic[sizeof(Magic)];
+    uint32_t version;
+    uint32_t cpu_count;     // followed by this many Cpu entries
+};
+
+struct Cpu {
+    uint64_t microcode;
+    uint64_t ppin;
+    int32_t cpu_number;
+    int16_t package_id;
+    int16_t numa_id;
+    int16_t module_id;
+    int16_t core_id;
+    int16_t thread_id;
+    uint16_t model;
+    uint8_t family;
+    uint8_t stepping;
+    uint8_t reserved[6];
+};
+
+struct Record {
+    uint32_t size;          // of the payload
+    RecordType type;
+    uint8_t reserved[3];
+    int32_t thread;         // negative for main threads, like the loggers
+    uint32_t test_count;
+    int64_t timestamp_ns;   // since the start of the run
+};
+
+struct ThreadInfo {
+    int64_t time_to_fail_ns;        // -1 if the thread didn't fail
+    uint64_t loop_count_at_fail;
+    uint64_t loop_count;
+    double freq_mhz;
+};
+
+static_assert(sizeof(FileHeader) == 16);
+static_assert(sizeof(Cpu) == 40);
+static_assert(sizeof(Record) == 24);
+static_assert(sizeof(ThreadInfo) == 32);
+
+static void write_file_header()
+{
+    FileHeader header = { .version = Version, .cpu_count = uint32_t(num_cpus()) };
+    memcpy(header.magic, Magic, sizeof(Magic));
+    std::vector<Cpu> cpus(num_cpus());
+    for (int i = 0; i < num_cpus(); ++i) {
+        const struct cpu_info &info = cpu_info[i];
+        cpus[i] = Cpu{
+            .microcode = info.microcode, .ppin = info.ppin, .cpu_number = info.cpu_number,
+            .package_id = info.package_id, .numa_id = info.numa_id, .module_id = info.module_id,
+            .core_id = info.core_id, .thread_id = info.thread_id, .model = info.model,
+            .family = info.family, .stepping = info.stepping,
+        };
+    }
+    struct iovec vec[] = {
+        { &header, sizeof(header) },
+        { cpus.data(), cpus.size() * sizeof(Cpu) },
+    };
+    IGNORE_RETVAL(writev(binary_log_fd, vec, std::size(vec)));
+}
+
+static Record make_record(RecordType type, int thread, size_t size)
+{
+    static bool header_written = false;
+    if (!header_written) {
+        write_file_header();
+        header_written = true;
+    }
+
+    struct timespec elapsed = elapsed_runtime();
+    return Record{
+        .size = uint32_t(size), .type = type, .thread = thread,
+        .test_count = uint32_t(sApp->current_test_count),
+        .timestamp_ns = elapsed.tv_sec * INT64_C(1000'000'000) + elapsed.tv_nsec,
+    };
+}
+
+static std::string_view result_string(TestResult result)
+{
+    // same strings as YamlLogger::print_result_line()
+    switch (result) {
+    case TestResult::Skipped:
+        return "skip";
+    case TestResult::Passed:
+        return "pass";
+    case TestResult::Failed:
+        return "fail";
+    case TestResult::TimedOut:
+        return "timed out";
+    case TestResult::Interrupted:
+        return "interrupted";
+    case TestResult::OperatingSystemError:
+        return "operating system error";
+    case TestResult::CoreDumped:
+    case TestResult::OutOfMemory:
+    case TestResult::Killed:
+        return "crash";
+    }
+    __builtin_unreachable();
+}
+
+static void write_test_record(const struct test *test, TestResult result)
+{
+    std::string_view id = test->id;
+    std::string_view res = result_string(result);
+    Record record = make_record(TestRecord, -1, id.size() + res.size() + 2);
+    static const char terminator = '\0';
+    IoVecMaker maker;
+    struct iovec vec[] = {
+        maker(&record, sizeof(record)), maker(id), maker(terminator), maker(res), maker(terminator)
+    };
+    IGNORE_RETVAL(writev(binary_log_fd, vec, std::size(vec)));
+}
+
+static void write_thread_record(int thread, mmap_region r)
+{
+    ThreadInfo info = { .time_to_fail_ns = -1, .freq_mhz = NAN };
+    if (thread >= 0) {
+        const PerThreadData::Test *thr = sApp->test_thread_data(thread);
+        if (thr->fail_time != MonotonicTimePoint() && thr->fail_time != MonotonicTimePoint::max()) {
+            auto time_to_fail = thr->fail_time - sApp->current_test_starttime;
+            info.time_to_fail_ns = std::chrono::nanoseconds(time_to_fail).count();
+        }
+        info.loop_count_at_fail = thr->inner_loop_count_at_fail;
+        info.loop_count = thr->inner_loop_count;
+        info.freq_mhz = thr->effective_freq_mhz;
+    }
+
+    Record record = make_record(ThreadRecord, thread, sizeof(info) + r.size);
+    struct iovec vec[] = {
+        { &record, sizeof(record) },
+        { &info, sizeof(info) },
+        { const_cast<void *>(r.base), r.size },
+    };
+    IGNORE_RETVAL(writev(binary_log_fd, vec, std::size(vec)));
+}
+} // namespace BinaryLog
+
+/// Returns the lowest (most important) level among the messages in \c{r}
+static int lowest_message_level(mmap_region r)
+{
+    int lowest_level = INT_MAX;
+    auto ptr = static_cast<const char *>(r.base);
+    const char *end = ptr + r.size;
+    const char *delim;
+    for ( ; ptr < end && (delim = strnchr(ptr, '\0', end - ptr)) != nullptr; ptr = delim + 1) {
+        uint8_t code = uint8_t(*ptr);
+        if (log_type_from_code(code) != UsedKnobValue)
+            lowest_level = std::min(lowest_level, level_from_code(code));
+    }
+    return lowest_level;
+}
+
 void YamlLogger::print()
 {
     Duration test_duration = MonotonicTimePoint::clock::now() - sApp->current_test_starttime;
@@ -2474,10 +2812,13 @@ void YamlLogger::print()
             if (count && real_stdout_fd != file_log_fd
                     && sApp->shmem->verbosity >= UsedKnobValueLoggingLevel)
                 print_test_knobs(real_stdout_fd, main_mmap);
-            munmap_file(main_mmap);
+            munmap_log(sApp->main_thread_data(), main_mmap);
         }
     }
 
+    if (binary_log_fd != -1)
+        BinaryLog::write_test_record(test, testResult);
+
     // print the thread messages
     auto doprint = [this, init_skip_message_bytes](PerThreadData::Common *data, int s_tid) {
         struct mmap_region r = maybe_mmap_log(data);
@@ -2490,6 +2831,20 @@ void YamlLogger::print()
             return;             /* nothing to be printed, on any level */
         }
 
+        if (binary_log_fd != -1) {
+            // the log file gets the messages unformatted; we only need to
+            // format what the verbosity level says goes to stdout, which at
+            // the default level only happens for failed threads
+            BinaryLog::write_thread_record(s_tid, r);
+            if (file_log_fd != real_stdout_fd && (data->has_failed() || sApp->shmem->verbosity > 0)
+                    && lowest_message_level(r) <= sApp->shmem->verbosity) {
+                print_thread_header(real_stdout_fd, s_tid, sApp->shmem->verbosity);
+                print_one_thread_messages(real_stdout_fd, r, sApp->shmem->verbosity);
+            }
+            munmap_and_truncate_log(data, r);
+            return;
+        }
+
         print_thread_header(file_log_fd, s_tid, INT_MAX);
         int lowest_level = print_one_thread_messages(file_log_fd, r, INT_MAX);
 
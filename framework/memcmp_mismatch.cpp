@@ -0,0 +1,159 @@
+/*
+ * Copyright 2025 Intel Corporation.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "memcmp_mismatch.h"
+#include "cpu_features.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include <string.h>
+
+#ifdef __x86_64__
+#  include <immintrin.h>
+#endif
+
+namespace {
+struct MismatchAccumulator
+{
+    MemcmpMismatchMap *map;
+    const uint8_t *actual;
+    const uint8_t *expected;
+    size_t element_size;
+    size_t last_element = SIZE_MAX;
+
+    void add_byte(size_t offset)
+    {
+        unsigned x = actual[offset] ^ expected[offset];
+        size_t element = offset / element_size;
+        size_t pos = offset - element * element_size;
+        if (element != last_element) {
+            last_element = element;
+            if (map->offset_count < MemcmpMismatchMap::MaxOffsets)
+                map->offsets[map->offset_count++] = offset;
+            ++map->count;
+        }
+        if (pos >= MemcmpMismatchMap::MaxElementSize)
+            return;
+        for ( ; x; x &= x - 1)
+            ++map->bit_histogram[pos * 8 + __builtin_ctz(x)];
+    }
+
+    // bit N of mask set means byte base + N differs
+    void add_mask(size_t base, uint64_t mask)
+    {
+        for ( ; mask; mask &= mask - 1)
+            add_byte(base + __builtin_ctzll(mask));
+    }
+};
+} // unnamed namespace
+
+static size_t scan_generic(MismatchAccumulator &acc, size_t start, size_t size)
+{
+    size_t i = start;
+    for ( ; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+        uint64_t a, e;
+        memcpy(&a, acc.actual + i, sizeof(a));
+        memcpy(&e, acc.expected + i, sizeof(e));
+        if (a == e)
+            continue;
+        for (size_t j = 0; j < sizeof(uint64_t); ++j) {
+            if (acc.actual[i + j] != acc.expected[i + j])
+                acc.add_byte(i + j);
+        }
+    }
+    for ( ; i < size; ++i) {
+        if (acc.actual[i] != acc.expected[i])
+            acc.add_byte(i);
+    }
+    return i;
+}
+
+#ifdef __x86_64__
+__attribute__((target("avx2")))
+static uint64_t avx2_difference_mask(const uint8_t *a, const uint8_t *e)
+{
+    __m256i a0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a));
+    __m256i a1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + 32));
+    __m256i e0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(e));
+    __m256i e1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(e + 32));
+    uint32_t eq0 = _mm256_movemask_epi8(_mm256_cmpeq_epi8(a0, e0));
+    uint32_t eq1 = _mm256_movemask_epi8(_mm256_cmpeq_epi8(a1, e1));
+    return ~(eq0 | uint64_t(eq1) << 32);
+}
+
+__attribute__((target("avx2")))
+static size_t scan_avx2(MismatchAccumulator &acc, size_t size)
+{
+    // 128 bytes per iteration; the common case is that all of it matches
+    size_t i = 0;
+    for ( ; i + 128 <= size; i += 128) {
+        const uint8_t *a = acc.actual + i;
+        const uint8_t *e = acc.expected + i;
+        __m256i x0 = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(a)),
+                                      _mm256_loadu_si256(reinterpret_cast<const __m256i *>(e)));
+        __m256i x1 = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + 32)),
+                                      _mm256_loadu_si256(reinterpret_cast<const __m256i *>(e + 32)));
+        __m256i x2 = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + 64)),
+                                      _mm256_loadu_si256(reinterpret_cast<const __m256i *>(e + 64)));
+        __m256i x3 = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + 96)),
+                                      _mm256_loadu_si256(reinterpret_cast<const __m256i *>(e + 96)));
+        __m256i any = _mm256_or_si256(_mm256_or_si256(x0, x1), _mm256_or_si256(x2, x3));
+        if (_mm256_testz_si256(any, any))
+            continue;
+
+        acc.add_mask(i, avx2_difference_mask(a, e));
+        acc.add_mask(i + 64, avx2_difference_mask(a + 64, e + 64));
+    }
+    for ( ; i + 64 <= size; i += 64)
+        acc.add_mask(i, avx2_difference_mask(acc.actual + i, acc.expected + i));
+    return i;
+}
+
+__attribute__((target("avx512f,avx512bw,bmi2")))
+static size_t scan_avx512(MismatchAccumulator &acc, size_t size)
+{
+    size_t i = 0;
+    for ( ; i + 128 <= size; i += 128) {
+        const uint8_t *a = acc.actual + i;
+        const uint8_t *e = acc.expected + i;
+        __mmask64 m0 = _mm512_cmpneq_epu8_mask(_mm512_loadu_si512(a), _mm512_loadu_si512(e));
+        __mmask64 m1 = _mm512_cmpneq_epu8_mask(_mm512_loadu_si512(a + 64), _mm512_loadu_si512(e + 64));
+        if ((m0 | m1) == 0)
+            continue;
+        acc.add_mask(i, m0);
+        acc.add_mask(i + 64, m1);
+    }
+
+    // the tail, with a masked load
+    if (size_t tail = size - i) {
+        __mmask64 k = tail >= 64 ? ~__mmask64(0) : _bzhi_u64(~uint64_t(0), tail);
+        __m512i a = _mm512_maskz_loadu_epi8(k, acc.actual + i);
+        __m512i e = _mm512_maskz_loadu_epi8(k, acc.expected + i);
+        acc.add_mask(i, _mm512_cmpneq_epu8_mask(a, e));
+        i += std::min<size_t>(tail, 64);
+    }
+    return i;
+}
+#endif
+
+void memcmp_mismatch_map(MemcmpMismatchMap *map, const uint8_t *actual, const uint8_t *expected,
+                         size_t size, size_t element_size, uint64_t features)
+{
+    map->count = 0;
+    map->offset_count = 0;
+    std::fill(std::begin(map->bit_histogram), std::end(map->bit_histogram), 0);
+
+    MismatchAccumulator acc = { map, actual, expected, std::max<size_t>(element_size, 1) };
+    size_t done = 0;
+#ifdef __x86_64__
+    constexpr uint64_t Avx512 = cpu_feature_avx512f | cpu_feature_avx512bw | cpu_feature_bmi2;
+    if ((features & Avx512) == Avx512)
+        done = scan_avx512(acc, size);
+    else if (features & cpu_feature_avx2)
+        done = scan_avx2(acc, size);
+#endif
+    scan_generic(acc, done, size);
+}
@@ -0,0 +1,42 @@
+/*
+ * Copyright 2025 Intel Corporation.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef SANDSTONE_MEMCMP_MISMATCH_H
+#define SANDSTONE_MEMCMP_MISMATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Summary of every difference between two buffers, gathered in a single
+ * pass when memcmp_or_fail() finds a mismatch. Defective vector units tend
+ * to corrupt many lanes or cache lines at once, so the count and the
+ * per-bit histogram characterize the failure better than the first offset
+ * alone.
+ */
+struct MemcmpMismatchMap
+{
+    static constexpr int MaxOffsets = 8;
+    static constexpr int MaxElementSize = 16;
+
+    size_t count;                       // number of elements that differ
+    int offset_count;                   // number of entries in offsets[]
+    ptrdiff_t offsets[MaxOffsets];      // first differing byte of the first mismatching elements
+
+    // number of mismatching elements in which each bit flipped, indexed by
+    // byte-in-element * 8 + bit (little endian)
+    uint32_t bit_histogram[MaxElementSize * 8];
+
+    ptrdiff_t first_offset() const
+    { return count ? offsets[0] : -1; }
+};
+
+// Compares size bytes at actual and expected, split in elements of
+// element_size bytes, using the widest vector code allowed by features (a
+// mask of cpu_feature_xxx bits).
+void memcmp_mismatch_map(MemcmpMismatchMap *map, const uint8_t *actual, const uint8_t *expected,
+                         size_t size, size_t element_size, uint64_t features);
+
+#endif // SANDSTONE_MEMCMP_MISMATCH_H
@@ -12,6 +12,8 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <condition_variable>
 #include <iterator>
 #include <new>
 #include <map>
@@ -43,8 +45,12 @@
 #  include <sys/auxv.h>
 #endif
 #ifdef __linux__
+#  include <sched.h>
+#  include <sys/epoll.h>
 #  include <sys/eventfd.h>
 #  include <sys/prctl.h>
+#  include <sys/socket.h>
+#  include <sys/timerfd.h>
 #  include <sys/types.h>
 #endif
 #ifdef __unix__
@@ -56,6 +62,8 @@
 
 #include "cpu_features.h"
 #include "forkfd.h"
+#include "fracture_cache.h"
+#include "memcmp_mismatch.h"
 
 #include "sandstone.h"
 #include "sandstone_p.h"
@@ -65,7 +73,9 @@
 #include "sandstone_thread.h"
 #include "sandstone_tests.h"
 #include "sandstone_utils.h"
+#include "perf_counters.hpp"
 #include "topology.h"
+#include "weighted_test_scheduler.h"
 
 #if SANDSTONE_SSL_BUILD
 #  include "sandstone_ssl.h"
@@ -87,6 +97,11 @@
 #endif
 
 
+#ifdef __x86_64__
+#  include <cpuid.h>
+#  include <x86intrin.h>
+#endif
+
 #ifndef O_PATH
 #  define O_PATH        0
 #endif
@@ -348,18 +363,6 @@ void _report_fail_msg(const char *file, int line, const char *fmt, ...)
     report_fail_common();
 }
 
-/* Like memcmp(), but returns the offset of the byte that differed (negative if equal) */
-static ptrdiff_t memcmp_offset(const uint8_t *d1, const uint8_t *d2, size_t size)
-{
-    ptrdiff_t i = 0;
-
-    for (; i < (ptrdiff_t) size; ++i) {
-        if (d1[i] != d2[i])
-            return i;
-    }
-    return -1;
-}
-
 void _memcmp_fail_report(const void *_actual, const void *_expected, size_t size, DataType type, const char *fmt, ...)
 {
     // Execute UD2 early if we've failed
@@ -372,11 +375,16 @@ void _memcmp_fail_report(const void *_actual, const void *_expected, size_t size
 
         auto actual = static_cast<const uint8_t *>(_actual);
         auto expected = static_cast<const uint8_t *>(_expected);
-        ptrdiff_t offset = memcmp_offset(actual, expected, size);
+        size_t element_size = 1;
+        if (SandstoneDataDetails::type_name(type))
+            element_size = SandstoneDataDetails::type_size(type);
+
+        MemcmpMismatchMap mismatches;
+        memcmp_mismatch_map(&mismatches, actual, expected, size, element_size, cpu_features);
 
         va_list va;
         va_start(va, fmt);
-        logging_report_mismatched_data(type, actual, expected, size, offset, fmt, va);
+        logging_report_mismatched_data(type, actual, expected, size, mismatches, fmt, va);
         va_end(va);
     }
 
@@ -635,6 +643,75 @@ static bool wallclock_deadline_has_expired(MonotonicTimePoint deadline)
     return false;
 }
 
+// TSC ticks per steady_clock tick, or 0 if we can't use the TSC
+static double tsc_ticks_per_clock_tick = 0;
+
+static uint64_t read_tsc()
+{
+#ifdef __x86_64__
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static void calibrate_tsc()
+{
+#ifdef __x86_64__
+    // only if the TSC is invariant (runs at a constant rate)
+    unsigned eax, ebx, ecx, edx;
+    if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) || (edx & (1U << 8)) == 0)
+        return;
+
+    MonotonicTimePoint start = MonotonicTimePoint::clock::now();
+    uint64_t tsc_start = read_tsc();
+    MonotonicTimePoint now;
+    do {
+        now = MonotonicTimePoint::clock::now();
+    } while (now - start < 1ms);
+    tsc_ticks_per_clock_tick = double(read_tsc() - tsc_start) / (now - start).count();
+#endif
+}
+
+static void set_current_test_deadline(Duration duration)
+{
+    MonotonicTimePoint now;
+    MonotonicTimePoint deadline = calculate_wallclock_deadline(duration, &now);
+    uint64_t tsc_now = read_tsc();
+    sApp->current_test_starttime = now;
+    sApp->shmem->current_test_endtime = deadline;
+
+    // Compute a TSC value that comes a little before the deadline, so the
+    // test threads don't need to read the clock until then.
+    uint64_t tsc_deadline = 0;
+    if (sApp->shmem->use_strict_runtime)
+        deadline = std::min(deadline, sApp->endtime);
+    if (tsc_ticks_per_clock_tick && deadline > now) {
+        Duration remaining = deadline - now;
+        double ticks = (remaining - remaining / 64).count() * tsc_ticks_per_clock_tick;
+        if (ticks < double(UINT64_MAX - tsc_now))
+            tsc_deadline = tsc_now + uint64_t(ticks);
+        else
+            tsc_deadline = UINT64_MAX;
+    }
+    sApp->shmem->current_test_tsc_endtime = tsc_deadline;
+}
+
+static bool test_deadline_has_expired()
+{
+    // One load of a shared flag and one RDTSC for most iterations. We only
+    // read the clock when we're close to the deadline.
+    std::atomic<bool> &expired = sApp->main_thread_data()->test_deadline_expired;
+    if (expired.load(std::memory_order_relaxed))
+        return true;
+    if (read_tsc() < sApp->shmem->current_test_tsc_endtime)
+        return false;
+    if (!wallclock_deadline_has_expired(sApp->shmem->current_test_endtime))
+        return false;
+    expired.store(true, std::memory_order_relaxed);
+    return true;
+}
+
 static bool max_loop_count_exceeded(const struct test *the_test)
 {
     PerThreadData::Test *data = sApp->test_thread_data(thread_num);
@@ -662,7 +739,7 @@ bool test_time_condition() noexcept
     if (max_loop_count_exceeded(current_test))
         return 0;  // end the test if max loop count exceeded
 
-    return !wallclock_deadline_has_expired(sApp->shmem->current_test_endtime);
+    return !test_deadline_has_expired();
 }
 
 bool test_loop_condition(int N) noexcept
@@ -694,12 +771,171 @@ static string format_socket_temperature_string(const vector<int> & temps)
     return temp_string;
 }
 
+#ifdef __linux__
+namespace {
+// Reads the thermal sensors on behalf of the main thread, from a thread that
+// runs at idle priority and, if there are any, on CPUs that aren't under
+// test. The main thread doesn't wait for the reading: it gets the latest
+// completed sample and the request for the next one is queued. Only the
+// very first call blocks, so there is always something to report.
+class ThermalSampler
+{
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::vector<int> latest;
+    bool requested = false;     // a sample is queued or being taken
+    bool have_sample = false;
+    bool started = false;
+
+    static void *run(void *ptr)
+    {
+        auto self = static_cast<ThermalSampler *>(ptr);
+        prctl(PR_SET_NAME, "thermal-sampler");
+
+        struct sched_param param = {};
+        IGNORE_RETVAL(pthread_setschedparam(pthread_self(), SCHED_IDLE, &param));
+
+        LogicalProcessorSet cpus = ambient_logical_processor_set();
+        for (int i = 0; i < num_cpus(); ++i)
+            cpus.unset(LogicalProcessor(cpu_info[i].cpu_number));
+        if (!cpus.empty())
+            sched_setaffinity(0, cpus.size_bytes(), reinterpret_cast<cpu_set_t *>(cpus.array.data()));
+
+        std::unique_lock lock(self->mutex);
+        for (;;) {
+            self->cond.wait(lock, [&] { return self->requested; });
+            lock.unlock();
+            std::vector<int> temps = ThermalMonitor::get_all_socket_temperatures();
+            lock.lock();
+            self->latest = std::move(temps);
+            self->have_sample = true;
+            self->requested = false;
+            self->cond.notify_all();
+        }
+        return nullptr;
+    }
+
+public:
+    ThermalSampler()
+    {
+        pthread_t thread;
+        started = pthread_create(&thread, nullptr, run, this) == 0;
+        if (started)
+            pthread_detach(thread);
+    }
+
+    std::vector<int> sample()
+    {
+        if (!started)
+            return ThermalMonitor::get_all_socket_temperatures();
+
+        std::unique_lock lock(mutex);
+        if (!requested) {
+            requested = true;
+            cond.notify_all();
+        }
+        cond.wait(lock, [&] { return have_sample; });
+        return latest;
+    }
+};
+} // unnamed namespace
+
+static vector<int> sample_socket_temperatures()
+{
+    // intentionally leaked: the thread outlives everything
+    static ThermalSampler *sampler = new ThermalSampler;
+    return sampler->sample();
+}
+#else
+static vector<int> sample_socket_temperatures()
+{
+    return ThermalMonitor::get_all_socket_temperatures();
+}
+#endif
+
+// Waits until a few CPUs, spread over the system, run at the core frequency
+// FrequencyManager just set, so the fracture doesn't start at a transitional
+// frequency. We keep each sampled CPU busy while measuring it, as APERF and
+// MPERF only count while the CPU isn't idle.
+static void wait_for_frequency_settle()
+{
+    static constexpr int MaxSampledCpus = 4;
+    static constexpr double Tolerance = 0.05;
+    static constexpr auto SampleInterval = 1ms;
+
+    struct Sampler {
+        int thread_num;
+        double target_mhz;
+        MonotonicTimePoint deadline;
+        MonotonicTimePoint settled = {};
+        double last_mhz = std::numeric_limits<double>::quiet_NaN();
+        pthread_t thread;
+
+        static void *run(void *ptr)
+        {
+            auto self = static_cast<Sampler *>(ptr);
+            pin_to_logical_processor(LogicalProcessor(cpu_info[self->thread_num].cpu_number),
+                                     "freq-settle");
+
+            CPUTimeFreqStamp before, after;
+            before.Snapshot(self->thread_num);
+            for (MonotonicTimePoint now = MonotonicTimePoint::clock::now(); now < self->deadline; ) {
+                MonotonicTimePoint next = now + SampleInterval;
+                while ((now = MonotonicTimePoint::clock::now()) < next)
+                    ;       // keep the CPU busy
+
+                after.Snapshot(self->thread_num);
+                self->last_mhz = CPUTimeFreqStamp::EffectiveFrequencyMHz(before, after);
+                if (std::isnan(self->last_mhz))
+                    break;          // can't read the MSRs
+                if (std::abs(self->last_mhz - self->target_mhz) <= self->target_mhz * Tolerance) {
+                    self->settled = now;
+                    break;
+                }
+                before = after;
+            }
+            return nullptr;
+        }
+    };
+
+    MonotonicTimePoint start = MonotonicTimePoint::clock::now();
+    double target_mhz = sApp->frequency_manager->current_core_frequency() / 1000.0;
+    int count = std::min(num_cpus(), MaxSampledCpus);
+    std::vector<Sampler> samplers;
+    samplers.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        Sampler &s = samplers.emplace_back(Sampler{
+                .thread_num = i * num_cpus() / count,
+                .target_mhz = target_mhz,
+                .deadline = start + sApp->frequency_settle_timeout,
+        });
+        pthread_create(&s.thread, nullptr, Sampler::run, &s);
+    }
+
+    MonotonicTimePoint settled = start;
+    bool all_settled = true;
+    for (Sampler &s : samplers) {
+        pthread_join(s.thread, nullptr);
+        if (s.settled == MonotonicTimePoint{}) {
+            all_settled = false;
+            logging_printf(LOG_LEVEL_VERBOSE(1),
+                           "# CPU %d did not settle at %.0f MHz within %s (last measured: %.0f MHz)\n",
+                           cpu_info[s.thread_num].cpu_number, target_mhz,
+                           format_duration(sApp->frequency_settle_timeout).c_str(), s.last_mhz);
+        }
+        settled = std::max(settled, s.settled);
+    }
+    if (all_settled)
+        logging_printf(LOG_LEVEL_VERBOSE(1), "# Frequency settled at %.0f MHz after %s\n",
+                       target_mhz, format_duration(settled - start).c_str());
+}
+
 static void print_temperature_and_throttle()
 {
     if (sApp->thermal_throttle_temp < 0)
         return;     // throttle disabled
 
-    vector<int> temperatures = ThermalMonitor::get_all_socket_temperatures();
+    vector<int> temperatures = sample_socket_temperatures();
 
     if (temperatures.empty()) return; // Cant find temperature files at all (probably on windows)
 
@@ -720,7 +956,7 @@ static void print_temperature_and_throttle()
         usleep(throttle_ms * 1000);
         sApp->threshold_time_remaining -= throttle_ms;
 
-        temperatures = ThermalMonitor::get_all_socket_temperatures();
+        temperatures = sample_socket_temperatures();
         highest_temp = *max_element(temperatures.begin(), temperatures.end());
     }
 
@@ -820,8 +1056,12 @@ static void cleanup_internal(const struct test *test)
     logging_finish();
 }
 
+static void child_pool_shutdown();
+
 static int cleanup_global(int exit_code, SandstoneApplication::PerCpuFailures per_cpu_failures)
 {
+    child_pool_shutdown();
+
     if (sApp->vary_frequency_mode)
         sApp->frequency_manager->restore_core_frequency_initial_state();
 
@@ -915,8 +1155,14 @@ void test_loop_end() noexcept
 
 static uintptr_t thread_runner(int thread_number)
 {
-    // convert from internal Sandstone numbering to the system one
-    pin_to_logical_processor(LogicalProcessor(cpu_info[thread_number].cpu_number), current_test->id);
+    // convert from internal Sandstone numbering to the system one (threads
+    // from the pool are already pinned, unless a reschedule moved them)
+    static thread_local int pinned_thread_number = -1;
+    LogicalProcessor lp = LogicalProcessor(cpu_info[thread_number].cpu_number);
+    if (pinned_thread_number == thread_number)
+        lp = LogicalProcessor(-1);      // only update the thread name
+    pin_to_logical_processor(lp, current_test->id);
+    pinned_thread_number = sApp->device_schedule ? -1 : thread_number;
 
     PerThreadData::Test *this_thread = sApp->test_thread_data(thread_number);
     random_init_thread(thread_number);
@@ -950,15 +1196,28 @@ static uintptr_t thread_runner(int thread_number)
 
     CPUTimeFreqStamp before;
     before.Snapshot(thread_number);
+    PerfCounterGroup perf_counters;
+    if (sApp->shmem->perf_counters)
+        perf_counters.start();
+
+    // record the counters even if the thread exits via report_fail() or
+    // pthread_cancel() and unwinds past us
+    auto stop_perf_counters = scopeExit([&] {
+        if (sApp->shmem->perf_counters)
+            perf_counters.stop(&this_thread->perf_counters);
+    });
     test_start();
 
+    MonotonicTimePoint run_start = MonotonicTimePoint::clock::now();
     try {
         ret = test_run_wrapper_function(current_test, thread_number);
     } catch (std::exception &e) {
         log_error("Caught C++ exception: \"%s\" (type '%s')", e.what(), typeid(e).name());
         // no rethrow
     }
+    this_thread->run_duration = MonotonicTimePoint::clock::now() - run_start;
 
+    stop_perf_counters.run_now();
     cleanup.run_now();
 
     CPUTimeFreqStamp after;
@@ -1027,7 +1286,7 @@ static void init_shmem()
     using namespace PerThreadData;
     static_assert(sizeof(PerThreadData::Main) == 64,
             "PerThreadData::Main size grew, please check if it was intended");
-    static_assert(sizeof(PerThreadData::Test) == 64,
+    static_assert(sizeof(PerThreadData::Test) == 128,
             "PerThreadData::Test size grew, please check if it was intended");
     assert(sApp->current_fork_mode() != SandstoneApplication::child_exec_each_test);
     assert(sApp->shmem == nullptr);
@@ -1082,12 +1341,24 @@ static void commit_shmem()
     size += sizeof(PerThreadData::Test) * num_cpus();
     size = ROUND_UP_TO_PAGE(size);
 
+    // followed by the log buffers, one per thread
+    ptrdiff_t log_buffer_offset = offset + size;
+    size += PerThreadData::LogBufferSize * (main_thread_count + num_cpus());
+
     if (ftruncate(sApp->shmemfd, offset + size) < 0) {
         perror("internal error: could not enlarge temporary file for sharing memory");
         exit(EX_CANTCREAT);
     }
     attach_shmem_internal(sApp->shmemfd, offset + size);
 
+    auto assign_log_buffer = [&](PerThreadData::Common *data, int) {
+        data->log_buffer_offset = log_buffer_offset;
+        data->log_buffer_used.store(0, std::memory_order_relaxed);
+        log_buffer_offset += PerThreadData::LogBufferSize;
+    };
+    for_each_main_thread(assign_log_buffer);
+    for_each_test_thread(assign_log_buffer);
+
     if (sApp->current_fork_mode() != SandstoneApplication::exec_each_test) {
         close(sApp->shmemfd);
         sApp->shmemfd = -1;
@@ -1307,29 +1578,18 @@ static void restart_init(int iterations)
 
 static void run_threads_in_parallel(const struct test *test)
 {
-    SandstoneTestThread thr[num_cpus()];    // NOLINT: -Wvla
-    int i;
-
-    for (i = 0; i < num_cpus(); i++) {
-        thr[i].start(thread_runner, i);
-    }
-    /* wait for threads to end */
-    for (i = 0; i < num_cpus(); i++) {
-        thr[i].join();
-    }
+    SandstoneTestThreadPool::run(thread_runner, num_cpus());
 }
 
 static void run_threads_sequentially(const struct test *test)
 {
-    // we still start one thread, in case the test uses report_fail_msg()
+    // we still use a thread, in case the test uses report_fail_msg()
     // (which uses pthread_cancel())
-    SandstoneTestThread thread;
-    thread.start([](int cpu) {
+    SandstoneTestThreadPool::run([](int cpu) {
         for ( ; cpu != num_cpus(); thread_num = ++cpu)
             thread_runner(cpu);
         return uintptr_t(cpu);
-    }, 0);
-    thread.join();
+    }, 1);
 }
 
 static void run_threads(const struct test *test)
@@ -1396,100 +1656,216 @@ struct ChildrenList
 
 static void wait_for_children(ChildrenList &children, const struct test *test)
 {
-    Duration remaining = test_timeout(sApp->current_test_duration);
+    // Each child has its own deadline: the test's timeout at first, then one
+    // escalation step for each attempt at stopping it (SIGQUIT, SIGKILL,
+    // giving up). The step scales with the timeout, so one hung child in a
+    // short run doesn't stall the whole slice for a minute.
+    enum ChildState : uint8_t { Running, Crashed, Terminating, Killed, Exited };
+    struct ChildWait {
+        MonotonicTimePoint deadline;
+        ChildState state = Running;
+    };
+
+    ShortDuration timeout = test_timeout(sApp->current_test_duration);
+    Duration escalation_step = std::clamp<Duration>(timeout / 10, 1s, 20s);
     int children_left = children.handles.size();
+    std::vector<ChildWait> waits(children_left, ChildWait{ MonotonicTimePoint::clock::now() + timeout });
     children.results.resize(children_left);
 
-#if !defined(_WIN32)
-    // add even if -1
-    children.pollfds.emplace_back(pollfd{ .fd = sApp->shmem->server_debug_socket, .events = POLLIN });
-    auto remove_debug_socket = scopeExit([&] { children.pollfds.pop_back(); });
+    auto child_exited = [&](size_t i, ChildExitStatus result) {
+        children.results[i] = result;
+        waits[i].state = Exited;
+        --children_left;
+    };
+    auto handle_crashed_children = [&] {
+        // a child that has sent us its crash context is on its way out, so
+        // don't wait for the test's timeout if it gets stuck doing that
+        std::vector<int> crashed = debug_crashed_child(children.handles);
 
+        // debugging may have run gdb, so start the wait from when it returned
+        MonotonicTimePoint now = MonotonicTimePoint::clock::now();
+        for (int slice : crashed) {
+            if (waits[slice].state != Running)
+                continue;
+            waits[slice].state = Crashed;
+            waits[slice].deadline = now + escalation_step;
+        }
+    };
+
+#if !defined(_WIN32)
     static constexpr int TimeoutSignal = SIGQUIT;
-    auto kill_children = [&](int sig = SIGKILL) {
+    static constexpr int KillSignal = SIGKILL;
+    auto kill_child = [&](size_t i, int sig) {
         // Send the signal to the child's process group, so all its children
         // get the signal too.
-        for (pid_t child : children.handles) {
-            if (child)
-                kill(-child, sig);
+        if (pid_t child = children.handles[i])
+            kill(-child, sig);
+    };
+    auto kill_children = [&](int sig) {
+        for (size_t i = 0; i < children.handles.size(); ++i)
+            kill_child(i, sig);
+    };
+    auto abandon_child = [&](size_t i) {
+        pollfd &pfd = children.pollfds[i];
+        forkfd_close(pfd.fd);
+        pfd.fd = -1;
+        pfd.events = 0;
+    };
+    auto reap_child = [&](size_t i, MonotonicTimePoint now) {
+        pollfd &pfd = children.pollfds[i];
+        if (pfd.fd == -1)
+            return;
+
+        struct forkfd_info info;
+        struct rusage usage;
+        int ret;
+        EINTR_LOOP(ret, forkfd_wait4(pfd.fd, &info, WNOHANG, &usage));
+        if (ret == -1) {
+            if (errno == EAGAIN)
+                return;             // shouldn't happen...
+            perror("forkfd_wait");
+            exit(EX_OSERR);
         }
+        abandon_child(i);
+        children.handles[i] = 0;
+
+        ChildExitStatus result = test_result_from_exit_code(info);
+        result.endtime = now;
+        result.usage = usage;
+        child_exited(i, result);
     };
-    auto single_wait = [&, caughtSignal = 0](milliseconds timeout) mutable {
-        int ret = poll(children.pollfds.data(), children.pollfds.size(), timeout.count());
-        if (ret == 0)
-            return 0;           // timed out
 
-        if (__builtin_expect(ret < 0 && errno != EINTR, false)) {
-            perror("poll");
+    int caughtSignal = 0;
+    auto handle_poll_error = [&](const char *function) {
+        if (__builtin_expect(errno != EINTR, false)) {
+            perror(function);
             exit(EX_OSERR);
         }
-        if (ret < 0) {
-            // we've received a signal, which one?
-            auto [signal, count] = last_signal();
-            if (signal != 0) {
-                // forward the signal to all children
-                kill_children(signal);
-            }
 
-            // if it was SIGINT, we print a message and wait for the test
-            if (count == 1 && signal == SIGINT) {
-                logging_printf(LOG_LEVEL_QUIET, "# Caught SIGINT, stopping current test "
-                                                "(press Ctrl+C again to exit without waiting)\n");
-                logging_print_log_file_name();
-                enable_interrupt_catch();       // re-arm SIGINT handler
-                caughtSignal = signal;
-                return 0;
-            } else {
-                // for any other signal (e.g., SIGTERM), we don't
-                return int(signal);
-            }
+        // we've received a signal, which one?
+        auto [signal, count] = last_signal();
+        if (signal != 0) {
+            // forward the signal to all children
+            kill_children(signal);
+        }
+
+        // if it was SIGINT, we print a message and wait for the test
+        if (count == 1 && signal == SIGINT) {
+            logging_printf(LOG_LEVEL_QUIET, "# Caught SIGINT, stopping current test "
+                                            "(press Ctrl+C again to exit without waiting)\n");
+            logging_print_log_file_name();
+            enable_interrupt_catch();       // re-arm SIGINT handler
+            caughtSignal = signal;
+            return 0;
         }
 
+        // for any other signal (e.g., SIGTERM), we don't
+        return int(signal);
+    };
+
+#  ifdef __linux__
+    // Wait on all the children, the crash socket and a timer for the nearest
+    // deadline in a single epoll set.
+    static constexpr uint64_t DebugSocketKey = uint64_t(-1);
+    static constexpr uint64_t TimerKey = uint64_t(-2);
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    int timerfd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    if (__builtin_expect(epfd == -1 || timerfd == -1, false)) {
+        perror(epfd == -1 ? "epoll_create1" : "timerfd_create");
+        exit(EX_OSERR);
+    }
+    auto close_epoll = scopeExit([&] {
+        close(timerfd);
+        close(epfd);
+    });
+    auto watch = [&](int fd, uint64_t key) {
+        epoll_event ev = { .events = EPOLLIN, .data = { .u64 = key } };
+        if (fd != -1)
+            epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+    };
+    for (size_t i = 0; i < children.pollfds.size(); ++i)
+        watch(children.pollfds[i].fd, i);
+    watch(sApp->shmem->server_debug_socket, DebugSocketKey);
+    watch(timerfd, TimerKey);
+
+    auto single_wait = [&](MonotonicTimePoint deadline) {
+        auto since_epoch = deadline.time_since_epoch();
+        struct itimerspec its = {};
+        its.it_value.tv_sec = duration_cast<seconds>(since_epoch).count();
+        its.it_value.tv_nsec = duration_cast<nanoseconds>(since_epoch % 1s).count();
+        timerfd_settime(timerfd, TFD_TIMER_ABSTIME, &its, nullptr);
+
+        epoll_event events[64];
+        int ret = epoll_wait(epfd, events, std::size(events), -1);
+        if (ret < 0)
+            return handle_poll_error("epoll_wait");
+
         auto now = MonotonicTimePoint::clock::now();
-        if (pollfd &pfd = children.pollfds.back(); pfd.revents & POLLIN) {
-            // one child (or more than one) is crashing
-            debug_crashed_child(children.handles);
+        bool timer_only = true;
+        for (int n = 0; n < ret; ++n) {
+            if (events[n].data.u64 == TimerKey) {
+                uint64_t expirations;
+                IGNORE_RETVAL(read(timerfd, &expirations, sizeof(expirations)));
+            } else if (events[n].data.u64 == DebugSocketKey) {
+                // one child (or more than one) is crashing
+                handle_crashed_children();
+                now = MonotonicTimePoint::clock::now();
+                timer_only = false;
+            }
         }
 
         // check if any of the children have exited
-        for (int i = 0; i < children.pollfds.size() - 1; ++i) {
-            pollfd &pfd = children.pollfds[i];
-            if (pfd.revents == 0)
+        for (int n = 0; n < ret; ++n) {
+            uint64_t key = events[n].data.u64;
+            if (key == TimerKey || key == DebugSocketKey)
                 continue;
+            reap_child(key, now);
+            timer_only = false;
+        }
+        return timer_only ? 0 : caughtSignal;
+    };
+#  else
+    // add even if -1
+    children.pollfds.emplace_back(pollfd{ .fd = sApp->shmem->server_debug_socket, .events = POLLIN });
+    auto remove_debug_socket = scopeExit([&] { children.pollfds.pop_back(); });
 
-            // wait for this child
-            struct forkfd_info info;
-            struct rusage usage;
-            EINTR_LOOP(ret, forkfd_wait4(pfd.fd, &info, WNOHANG, &usage));
-            if (ret == -1) {
-                if (errno == EAGAIN)
-                    continue;           // shouldn't happen...
-                perror("forkfd_wait");
-                exit(EX_OSERR);
-            }
-            forkfd_close(pfd.fd);
-            pfd.fd = -1;
-            pfd.events = 0;
-            children.handles[i] = 0;
-            children.results[i] = test_result_from_exit_code(info);
-            children.results[i].endtime = now;
-            children.results[i].usage = usage;
-            --children_left;
+    auto single_wait = [&](MonotonicTimePoint deadline) {
+        milliseconds timeout = ceil<milliseconds>(deadline - MonotonicTimePoint::clock::now());
+        int ret = poll(children.pollfds.data(), children.pollfds.size(),
+                       int(std::clamp<int64_t>(timeout.count(), 0, INT_MAX)));
+        if (ret == 0)
+            return 0;           // timed out
+        if (ret < 0)
+            return handle_poll_error("poll");
+
+        if (pollfd &pfd = children.pollfds.back(); pfd.revents & POLLIN) {
+            // one child (or more than one) is crashing
+            handle_crashed_children();
+        }
+        auto now = MonotonicTimePoint::clock::now();
+
+        // check if any of the children have exited
+        for (size_t i = 0; i < children.pollfds.size() - 1; ++i) {
+            if (children.pollfds[i].revents)
+                reap_child(i, now);
         }
         return caughtSignal;
     };
+#  endif
 #elif defined(_WIN32)
     static constexpr DWORD TimeoutSignal = EXIT_TIMEOUT;
-    auto kill_children = [&](DWORD exitCode = DWORD(-1)) {
+    static constexpr DWORD KillSignal = DWORD(-1);
+    auto kill_child = [&](size_t i, DWORD exitCode) {
         // Note: Windows code cannot kill grand-children processes!
-        for (intptr_t child : children.handles) {
-            HANDLE hnd = HANDLE(child);
-            if (hnd == INVALID_HANDLE_VALUE)
-                continue;
+        HANDLE hnd = HANDLE(children.handles[i]);
+        if (hnd != INVALID_HANDLE_VALUE)
             TerminateProcess(hnd, exitCode);
-        }
     };
-    auto single_wait = [&](milliseconds timeout) {
+    auto abandon_child = [&](size_t i) {
+        CloseHandle(HANDLE(children.handles[i]));
+        children.handles[i] = intptr_t(INVALID_HANDLE_VALUE);
+    };
+    auto single_wait = [&](MonotonicTimePoint deadline) {
         HANDLE handles[MAXIMUM_WAIT_OBJECTS];
         DWORD nCount = 0;
         if (sApp->shmem->debug_event)
@@ -1502,7 +1878,10 @@ static void wait_for_children(ChildrenList &children, const struct test *test)
             ++nCount;
         }
         bool bWaitAll = false;
-        DWORD result = WaitForMultipleObjects(nCount, handles, bWaitAll, timeout.count());
+        milliseconds timeout = ceil<milliseconds>(deadline - MonotonicTimePoint::clock::now());
+        // clamp before converting, so a deadline in the past doesn't wrap
+        DWORD ms = DWORD(std::clamp<int64_t>(timeout.count(), 0, INFINITE - 1));
+        DWORD result = WaitForMultipleObjects(nCount, handles, bWaitAll, ms);
         if (__builtin_expect(result == WAIT_FAILED, false)) {
             fprintf(stderr, "%s: WaitForMultipleObjects() failed: %lx; children left = %d\n",
                     program_invocation_name, GetLastError(), children_left);
@@ -1514,7 +1893,7 @@ static void wait_for_children(ChildrenList &children, const struct test *test)
         int idx = result - WAIT_OBJECT_0;
         if (idx == 0 && sApp->shmem->debug_event) {
             // one child (or more than one) is crashing
-            debug_crashed_child(children.handles);
+            handle_crashed_children();
             return 0;
         }
 
@@ -1548,40 +1927,64 @@ static void wait_for_children(ChildrenList &children, const struct test *test)
         // close the handle and store result
         for (idx = 0; idx < int(children.handles.size()); ++idx) {
             if (hExited == HANDLE(children.handles[idx])) {
-                CloseHandle(hExited);
-                children.handles[idx] = intptr_t(INVALID_HANDLE_VALUE);
-                children.results[idx] = childResult;
+                abandon_child(idx);
+                child_exited(idx, childResult);
                 break;
             }
         }
-        --children_left;
         return 0;
     };
 #else
 #  error "What platform is this?"
 #endif
-    auto terminate_children = [&] {
-        for (size_t i = 0; i < children.handles.size(); ++i) {
+    auto escalate = [&](size_t i) {
+        ChildWait &w = waits[i];
+        switch (w.state) {
+        case Running: {
             auto child = children.handles[i];
-            if (children.results[i].endtime == MonotonicTimePoint{}) {
-                debug_hung_child(child, children.handles);
+            debug_hung_child(child, children.handles);
 #ifdef _WIN32
-                log_message(-int(i) - 1, SANDSTONE_LOG_ERROR "Child %ld did not exit, using TerminateProcess()",
-                            GetProcessId(HANDLE(child)));
+            log_message(-int(i) - 1, SANDSTONE_LOG_ERROR "Child %ld did not exit, using TerminateProcess()",
+                        GetProcessId(HANDLE(child)));
 #else
-                log_message(-int(i) - 1, SANDSTONE_LOG_ERROR "Child %d did not exit, sending signal SIGQUIT", child);
+            log_message(-int(i) - 1, SANDSTONE_LOG_ERROR "Child %d did not exit, sending signal SIGQUIT", child);
 #endif
-            }
+            kill_child(i, TimeoutSignal);
+            w.state = Terminating;
+            break;
+        }
+
+        case Crashed:
+        case Terminating:
+            // timed out again, take drastic measures
+            kill_child(i, KillSignal);
+            w.state = Killed;
+            break;
+
+        case Killed:
+            log_platform_message(SANDSTONE_LOG_ERROR "# Child %td is hung and won't exit",
+                                 intptr_t(children.handles[i]));
+            abandon_child(i);
+            child_exited(i, { TestResult::TimedOut });
+            return;
+
+        case Exited:
+            return;
         }
-        kill_children(TimeoutSignal);
+
+        // debug_hung_child() may have run gdb for a long time: give the child
+        // the full step from now to react to the signal
+        w.deadline = MonotonicTimePoint::clock::now() + escalation_step;
     };
-    auto wait_for_all_children = [&](Duration remaining) {
-        MonotonicTimePoint deadline = steady_clock::now() + remaining;
-        for ( ; children_left && remaining > 0s; remaining = deadline - steady_clock::now()) {
-            int ret = single_wait(ceil<milliseconds>(remaining));
-            if (ret == 0)
-                continue;
 
+    while (children_left) {
+        MonotonicTimePoint deadline = MonotonicTimePoint::max();
+        for (const ChildWait &w : waits) {
+            if (w.state != Exited)
+                deadline = std::min(deadline, w.deadline);
+        }
+
+        if (int ret = single_wait(deadline)) {
             for (ChildExitStatus &result : children.results)
                 result = { TestResult::Interrupted };
 
@@ -1597,30 +2000,11 @@ static void wait_for_children(ChildrenList &children, const struct test *test)
             raise(exit_code & 0x7f);
             _exit(exit_code);           // just in case
         }
-    };
 
-    /* first wait set : normal exit */
-    wait_for_all_children(remaining);
-    if (children_left == 0)
-        return;
-
-    /* at least one child timed out; force them to exit */
-    terminate_children();
-
-    /* wait for the termination to take effect */
-    wait_for_all_children(20s);
-    if (children_left) {
-        /* timed out again, take drastic measures */
-        kill_children();
-        wait_for_all_children(20s);
-    }
-    if (children_left) {
-        for (size_t i = 0; i < children.handles.size(); ++i) {
-            if (children.handles[i] == 0)
-                continue;
-            log_platform_message(SANDSTONE_LOG_ERROR "# Child %td is hung and won't exit",
-                                 intptr_t(children.handles[i]));
-            children.results[i] = { TestResult::TimedOut };
+        MonotonicTimePoint now = MonotonicTimePoint::clock::now();
+        for (size_t i = 0; i < waits.size(); ++i) {
+            if (waits[i].state != Exited && waits[i].deadline <= now)
+                escalate(i);
         }
     }
 }
@@ -1635,6 +2019,8 @@ static TestResult child_run(/*nonconst*/ struct test *test, int child_number)
         signals_init_child();
         debug_init_child();
     }
+    if (sApp->shmem->huge_pages)
+        malloc_enable_huge_pages();
 
     prepare_test(test);
 
@@ -1809,6 +2195,137 @@ static StartedChild call_forkfd()
     return { .pid = pid, .fd = ffd };
 }
 
+#ifdef __linux__
+namespace {
+// Children forked ahead of time (--fork-mode=pool), while the previous test
+// is running. Each one waits on a socket until it's handed a test, runs it
+// and exits, exactly like the regular fork_each_test children.
+struct PooledChild
+{
+    StartedChild child;
+    int sock;
+};
+
+// the state that the parent may have changed since the child was forked
+struct PooledChildHandoff
+{
+    struct test *test;
+    int child_number;
+    int current_iteration_count;
+    int current_test_count;
+    ShortDuration current_test_duration;
+    MonotonicTimePoint current_test_starttime;
+    char random_seed[128];
+};
+} // unnamed namespace
+
+static std::vector<PooledChild> child_pool;
+
+[[noreturn]] static void pooled_child_main(int sock)
+{
+    // don't get the parent's terminal signals while waiting
+    signals_init_child();
+
+    PooledChildHandoff h;
+    ssize_t n;
+    EINTR_LOOP(n, recv(sock, &h, sizeof(h), 0));
+    close(sock);
+    if (n != sizeof(h))
+        _exit(EXIT_SUCCESS);        // parent has exited or shut the pool down
+
+    sApp->current_iteration_count = h.current_iteration_count;
+    sApp->current_test_count = h.current_test_count;
+    sApp->current_test_duration = h.current_test_duration;
+    sApp->current_test_starttime = h.current_test_starttime;
+    random_init_global(h.random_seed);
+
+    logging_init_child_preexec();
+    TestResult result = child_run(h.test, h.child_number);
+    _exit(test_result_to_exit_code(result));
+}
+
+static void child_pool_refill()
+{
+    size_t target = sApp->shmem->main_thread_count;
+    while (child_pool.size() < target) {
+        int sv[2];
+        if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sv) < 0)
+            return;                 // we'll fork on demand instead
+
+        StartedChild child = call_forkfd();
+        if (child.fd == FFD_CHILD_PROCESS) {
+            close(sv[0]);
+            for (const PooledChild &c : child_pool)
+                close(c.sock);
+            pooled_child_main(sv[1]);
+        }
+        close(sv[1]);
+        child_pool.push_back({ child, sv[0] });
+    }
+}
+
+static void child_pool_discard(PooledChild &c)
+{
+    int ret;
+    close(c.sock);
+    EINTR_LOOP(ret, forkfd_wait(c.child.fd, nullptr, nullptr));
+    forkfd_close(c.child.fd);
+}
+
+static void child_pool_shutdown()
+{
+    // closing the sockets makes the children exit
+    for (PooledChild &c : child_pool)
+        close(c.sock);
+    for (PooledChild &c : child_pool) {
+        int ret;
+        EINTR_LOOP(ret, forkfd_wait(c.child.fd, nullptr, nullptr));
+        forkfd_close(c.child.fd);
+    }
+    child_pool.clear();
+}
+
+// returns { .fd = -1 } if there are no children in the pool
+static StartedChild child_pool_start(const struct test *test, int child_number)
+{
+    PooledChildHandoff h = {
+        .test = const_cast<struct test *>(test),
+        .child_number = child_number,
+        .current_iteration_count = sApp->current_iteration_count,
+        .current_test_count = sApp->current_test_count,
+        .current_test_duration = sApp->current_test_duration,
+        .current_test_starttime = sApp->current_test_starttime,
+    };
+    std::string random_seed = random_format_seed();
+    assert(random_seed.size() < sizeof(h.random_seed));
+    strncpy(h.random_seed, random_seed.c_str(), sizeof(h.random_seed) - 1);
+    h.random_seed[sizeof(h.random_seed) - 1] = '\0';
+
+    while (!child_pool.empty()) {
+        PooledChild c = child_pool.back();
+        child_pool.pop_back();
+
+        ssize_t n;
+        EINTR_LOOP(n, send(c.sock, &h, sizeof(h), MSG_NOSIGNAL));
+        if (n == sizeof(h)) {
+            close(c.sock);
+            return c.child;
+        }
+
+        // this child has died, try the next one
+        child_pool_discard(c);
+    }
+    return { .fd = -1 };
+}
+#else
+static void child_pool_refill() {}
+static void child_pool_shutdown() {}
+static StartedChild child_pool_start(const struct test *, int)
+{
+    return { .fd = -1 };
+}
+#endif // __linux__
+
 static StartedChild spawn_child(const struct test *test, int child_number)
 {
     assert(sApp->shmemfd != -1);
@@ -1923,8 +2440,13 @@ static void run_one_test_children(ChildrenList &children, const struct test *tes
 
         for (int i = 0; i < child_count; ++i) {
             StartedChild ret = { .fd = FFD_CHILD_PROCESS };
-            if (sApp->current_fork_mode() == SandstoneApplication::fork_each_test)
-                ret = call_forkfd();
+            if (sApp->current_fork_mode() == SandstoneApplication::fork_each_test) {
+                ret.fd = -1;
+                if (sApp->use_child_pool)
+                    ret = child_pool_start(test, i);
+                if (ret.fd == -1)
+                    ret = call_forkfd();
+            }
             if (ret.fd == FFD_CHILD_PROCESS) {
                 /* child - run test's code */
                 logging_init_child_preexec();
@@ -1943,6 +2465,10 @@ static void run_one_test_children(ChildrenList &children, const struct test *tes
             children.add(spawn_child(test, i));
     }
 
+    // prepare the children for the next test while this one runs
+    if (sApp->use_child_pool)
+        child_pool_refill();
+
     /* wait for the children */
     wait_for_children(children, test);
 }
@@ -2112,6 +2638,44 @@ static void analyze_test_failures(const struct test *test, int fail_count, int a
     }
 }
 
+static FractureCache fracture_cache;
+
+static void fracture_cache_init()
+{
+    if (sApp->fracture_cache_path.empty())
+        return;
+    // loop times depend on how many threads share the package, not just the model
+    std::string cpu_key = stdprintf("%02x-%02x-%02x-%d", cpu_info[0].family, cpu_info[0].model,
+                                    cpu_info[0].stepping, num_cpus());
+    fracture_cache = FractureCache(sApp->fracture_cache_path, std::move(cpu_key));
+    fracture_cache.load();
+}
+
+static void fracture_cache_save()
+{
+    if (fracture_cache.enabled() && !fracture_cache.save())
+        logging_printf(LOG_LEVEL_VERBOSE(1), "# WARNING: could not write fracture cache file %s: %m\n",
+                       sApp->fracture_cache_path.c_str());
+}
+
+static uint64_t max_inner_loop_count()
+{
+    uint64_t count = 0;
+    for_each_test_thread([&](PerThreadData::Test *data, int) {
+        count = std::max(count, data->inner_loop_count);
+    });
+    return count;
+}
+
+static Duration max_run_duration()
+{
+    Duration d = {};
+    for_each_test_thread([&](PerThreadData::Test *data, int) {
+        d = std::max(d, data->run_duration);
+    });
+    return d;
+}
+
 static TestResult
 run_one_test(const test_cfg_info &test_cfg, SandstoneApplication::PerCpuFailures &per_cpu_fails)
 {
@@ -2121,7 +2685,10 @@ run_one_test(const test_cfg_info &test_cfg, SandstoneApplication::PerCpuFailures
     std::unique_ptr<char[]> random_allocation;
     MonotonicTimePoint first_iteration_target;
     bool auto_fracture = false;
+    bool auto_fracture_from_cache = false;
     Duration runtime = 0ms;
+    Duration loop_time = 0ms;       // excludes the per-fracture overhead
+    uint64_t total_loops = 0;
 
     // resize and zero the storage
     if (per_cpu_fails.size() == num_cpus()) {
@@ -2166,6 +2733,17 @@ run_one_test(const test_cfg_info &test_cfg, SandstoneApplication::PerCpuFailures
         /* for automatic fracture mode, do a 40 loop count */
         sApp->shmem->current_max_loop_count = 40;
         auto_fracture = true;
+
+        // size the first fracture from the last measured loop time on this
+        // system, so it lands near the 10 ms target without doubling
+        const FractureCache::Entry *e = fracture_cache.find(test->id);
+        if (e && e->ns_per_loop) {
+            uint64_t loops = duration_cast<nanoseconds>(10ms).count() / e->ns_per_loop;
+            sApp->shmem->current_max_loop_count = int(std::clamp<uint64_t>(loops, 40, 1 << 20));
+            auto_fracture_from_cache = true;
+            logging_printf(LOG_LEVEL_VERBOSE(3), "# Fracture cache: starting at %d loops (%g us per loop)\n",
+                           sApp->shmem->current_max_loop_count, e->ns_per_loop / 1000.);
+        }
     } else {
         sApp->shmem->current_max_loop_count = test->fracture_loop_count;
     }
@@ -2183,19 +2761,23 @@ run_one_test(const test_cfg_info &test_cfg, SandstoneApplication::PerCpuFailures
         if (sApp->vary_uncore_frequency_mode == true)
             sApp->frequency_manager->change_uncore_frequency();
 
+        if (sApp->vary_frequency_mode && sApp->frequency_settle_timeout.count())
+            wait_for_frequency_settle();
+
         init_internal(test);
 
         // calculate starttime->endtime, reduce the overhead to have better test runtime calculations
-        sApp->shmem->current_test_endtime =
-                calculate_wallclock_deadline(sApp->current_test_duration - runtime,
-                                             &sApp->current_test_starttime);
+        set_current_test_deadline(sApp->current_test_duration - runtime);
         state = run_one_test_once(test);
         runtime += MonotonicTimePoint::clock::now() - sApp->current_test_starttime;
+        total_loops += max_inner_loop_count();
+        loop_time += max_run_duration();
 
         cleanup_internal(test);
 
         if ((sApp->shmem->current_max_loop_count > 0
-             && MonotonicTimePoint::clock::now() < first_iteration_target && auto_fracture))
+             && MonotonicTimePoint::clock::now() < first_iteration_target && auto_fracture
+             && !auto_fracture_from_cache))
             sApp->shmem->current_max_loop_count *= 2;
 
         /* don't repeat skipped tests */
@@ -2240,9 +2822,7 @@ run_one_test(const test_cfg_info &test_cfg, SandstoneApplication::PerCpuFailures
                 --sApp->total_retest_count;
             sApp->current_iteration_count = -iterations;
             init_internal(test);
-            sApp->shmem->current_test_endtime =
-                    calculate_wallclock_deadline(sApp->current_test_duration,
-                                                 &sApp->current_test_starttime);
+            set_current_test_deadline(sApp->current_test_duration);
             state = run_one_test_once(test);
             cleanup_internal(test);
 
@@ -2255,6 +2835,15 @@ run_one_test(const test_cfg_info &test_cfg, SandstoneApplication::PerCpuFailures
     }
 
 out:
+    if (auto_fracture && state == TestResult::Passed && fracture_cache.enabled() && total_loops) {
+        // always store the latest measurement: a slower run must be able
+        // to lower the cached start, not only a faster one raise it
+        FractureCache::Entry entry;
+        entry.loop_count = sApp->shmem->current_max_loop_count;
+        entry.ns_per_loop = duration_cast<nanoseconds>(loop_time).count() / total_loops;
+        fracture_cache.update(test->id, entry);
+    }
+
     //reset frequency level idx for the next test
     if (sApp->vary_frequency_mode || sApp->vary_uncore_frequency_mode)
         sApp->frequency_manager->reset_frequency_level_idx();
@@ -2339,17 +2928,31 @@ static void list_group_members(const char *groupname)
     exit(EX_USAGE);
 }
 
-static bool should_start_next_iteration(void)
+static int finished_iterations = 0;
+
+// Marks the end of a pass through the test list (or of a weighted
+// schedule round) and returns the average time per pass so far
+static Duration finish_iteration()
 {
-    static int iterations = 0;
-    ++iterations;
+    ++finished_iterations;
 
     Duration elapsed_time = MonotonicTimePoint::clock::now() - sApp->starttime;
-    Duration average_time(elapsed_time.count() / iterations);
+    Duration average_time(elapsed_time.count() / finished_iterations);
     logging_printf(LOG_LEVEL_VERBOSE(2), "# Loop iteration %d finished, average time %g ms, total %g ms\n",
-                   iterations, std::chrono::nanoseconds(average_time).count() / 1000. / 1000,
+                   finished_iterations, std::chrono::nanoseconds(average_time).count() / 1000. / 1000,
                    std::chrono::nanoseconds(elapsed_time).count() / 1000. / 1000);
+    return average_time;
+}
 
+static void start_next_iteration()
+{
+    fracture_cache_save();
+    restart_init(finished_iterations);
+}
+
+static bool should_start_next_iteration(void)
+{
+    Duration average_time = finish_iteration();
 
     if (!sApp->shmem->use_strict_runtime) {
         /* do we have time for one more run? */
@@ -2360,15 +2963,115 @@ static bool should_start_next_iteration(void)
             return false;
     }
     /* start from the beginning again */
-    restart_init(iterations);
+    start_next_iteration();
     return true;
 }
 
+static bool is_test_excluded_by_quality(const struct test *test)
+{
+    return test->quality_level < 0 && sApp->requested_quality >= 0;
+}
+
+// state for --weighted-schedule
+static struct WeightedScheduleState
+{
+    WeightedTestScheduler scheduler;
+    MonotonicTimePoint deadline;
+    int mce_index = -1;
+    int round_length = 0;       // picks per round (one per eligible test)
+    int picks = 0;
+    bool round_finished = false;
+} weighted_schedule;
+
+static ShortDuration weighted_schedule_remaining_time()
+{
+    if (weighted_schedule.deadline == MonotonicTimePoint::max())
+        return ShortDuration::max();
+    auto remaining = weighted_schedule.deadline - MonotonicTimePoint::clock::now();
+    if (remaining >= ShortDuration::max())
+        return ShortDuration::max();
+    return std::max(duration_cast<ShortDuration>(remaining), ShortDuration::zero());
+}
+
+static void weighted_schedule_init()
+{
+    WeightedScheduleState &w = weighted_schedule;
+    std::vector<WeightedTestScheduler::Candidate> candidates;
+    ShortDuration total = {};
+    std::span<test_cfg_info> entries = test_set->entries();
+    candidates.reserve(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const test_cfg_info &ti = entries[i];
+        WeightedTestScheduler::Candidate &c = candidates.emplace_back();
+        c.duration = test_duration(ti);
+        c.weight = ti.weight;
+        if (ti.test == &mce_test) {
+            // mce_check isn't scheduled, it closes each round
+            w.mce_index = i;
+            c.weight = 0;
+        } else if (is_test_excluded_by_quality(ti.test)) {
+            c.weight = 0;
+        }
+        if (c.weight > 0) {
+            total += c.duration;
+            ++w.round_length;
+        }
+    }
+    w.scheduler = WeightedTestScheduler(std::move(candidates));
+
+    // without -T, spend the same time a regular pass through the list would
+    if (sApp->endtime > sApp->starttime)
+        w.deadline = sApp->endtime;
+    else
+        w.deadline = MonotonicTimePoint::clock::now() + total;
+}
+
+static SandstoneTestSet::EnabledTestList::iterator weighted_schedule_next_test()
+{
+    WeightedScheduleState &w = weighted_schedule;
+    ShortDuration remaining = weighted_schedule_remaining_time();
+    if (!w.round_finished) {
+        int idx = -1;
+        if (w.picks < w.round_length)
+            idx = w.scheduler.next(remaining);
+        if (idx >= 0) {
+            ++w.picks;
+            return test_set->at(idx);
+        }
+
+        w.round_finished = true;
+        if (w.mce_index >= 0)
+            return test_set->at(w.mce_index);
+    }
+
+    // start another round, if anything still fits in the budget
+    finish_iteration();
+    if (!w.scheduler.fits(remaining))
+        return test_set->end();
+    w.round_finished = false;
+    w.picks = 0;
+    start_next_iteration();
+    logging_print_iteration_start();
+    return weighted_schedule_next_test();
+}
+
+static void weighted_schedule_test_skipped(SandstoneTestSet::EnabledTestList::iterator it)
+{
+    // don't keep picking a test that can't run here
+    int idx = it - test_set->at(0);
+    if (idx != weighted_schedule.mce_index)
+        weighted_schedule.scheduler.drop(idx);
+}
+
 static SandstoneTestSet::EnabledTestList::iterator get_first_test()
 {
     logging_print_iteration_start();
+    if (sApp->weighted_schedule) {
+        weighted_schedule_init();
+        return weighted_schedule_next_test();
+    }
     auto it = test_set->begin();
-    while (it != test_set->end() && (it->test->quality_level < 0 && sApp->requested_quality >= 0))
+    while (it != test_set->end() && is_test_excluded_by_quality(it->test))
         ++it;
     return it;
 }
@@ -2379,9 +3082,11 @@ get_next_test(SandstoneTestSet::EnabledTestList::iterator next_test)
 {
     if (sApp->shmem->use_strict_runtime && wallclock_deadline_has_expired(sApp->endtime))
         return test_set->end();
+    if (sApp->weighted_schedule)
+        return weighted_schedule_next_test();
 
     ++next_test;
-    while (next_test != test_set->end() && (next_test->test->quality_level < 0 && sApp->requested_quality >= 0))
+    while (next_test != test_set->end() && is_test_excluded_by_quality(next_test->test))
         ++next_test;
     if (next_test == test_set->end()) {
         if (should_start_next_iteration()) {
@@ -2859,6 +3564,7 @@ int main(int argc, char **argv)
     cpu_specific_init();
     random_init_global(opts.seed);
     background_scan_init();
+    calibrate_tsc();
 
     if (opts.enabled_tests.size() || opts.builtin_test_list_name || opts.test_list_file_path) {
         /* if anything other than the "all tests" has been specified, start with
@@ -2920,8 +3626,10 @@ int main(int argc, char **argv)
         sApp->shmem->verbosity = (sApp->requested_quality < SandstoneApplication::DefaultQualityLevel) ? 1 : 0;
 
     if (InterruptMonitor::InterruptMonitorWorks && test_set->contains(&mce_test)) {
-        sApp->last_thermal_event_count = sApp->count_thermal_events();
-        sApp->mce_counts_start = sApp->get_mce_interrupt_counts();
+        InterruptMonitor::InterruptCounts counts = sApp->sample_interrupt_counts();
+        sApp->last_thermal_event_count =
+                std::accumulate(counts.thermal.begin(), counts.thermal.end(), uint64_t(0));
+        sApp->mce_counts_start = std::move(counts.mce);
 
         if (sApp->current_fork_mode() == SandstoneApplication::exec_each_test) {
             test_set->remove(&mce_test);
@@ -2955,6 +3663,7 @@ int main(int argc, char **argv)
     }
 #endif
 
+    fracture_cache_init();
     logging_print_header(argc, argv, test_duration(), test_timeout(test_duration()));
 
     SandstoneApplication::PerCpuFailures per_cpu_failures;
@@ -2991,6 +3700,8 @@ int main(int argc, char **argv)
             ++total_successes;
         } else if (lastTestResult == TestResult::Skipped) {
             ++total_skips;
+            if (sApp->weighted_schedule)
+                weighted_schedule_test_skipped(it);
             if (sApp->fatal_skips)
                 break;
         }
@@ -3005,6 +3716,8 @@ int main(int argc, char **argv)
                        total_successes, total_tests_run - total_successes);
     }
 
+    fracture_cache_save();
+
     int exit_code = EXIT_SUCCESS;
     if (total_failures || (total_skips && sApp->fatal_skips))
         exit_code = EXIT_FAILURE;
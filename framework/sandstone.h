@@ -590,6 +590,17 @@ extern void log_data(const char *message, const void *data, size_t size);
 /// this function is only supported on Linux and requires root
 /// privileges.
 uint64_t retrieve_physical_address(const volatile void *ptr);
+/// retrieves the physical addresses of the pages spanned by the buffer
+/// starting at ptr and len bytes long, storing up to count of them in the
+/// addresses array.  The first entry is the physical address of ptr itself
+/// and the others are those of the start of each subsequent page; pages
+/// that are not present in RAM are reported as 0.  Returns the number of
+/// pages in the buffer (which may be more than count) or 0 on error.  This
+/// is much faster than calling retrieve_physical_address for each page.
+/// Like it, this function is only supported on Linux and requires root
+/// privileges.
+size_t retrieve_physical_address_range(const volatile void *ptr, size_t len,
+                                       uint64_t *addresses, size_t count);
 
 /// reads the value of the MSR, specified by msr, of CPU cpu.
 /// The value is returned in the value parameter.  The function
@@ -597,6 +608,12 @@ uint64_t retrieve_physical_address(const volatile void *ptr);
 /// This function is only supported on Linux and requires root
 /// privileges.
 bool read_msr(int cpu, uint32_t msr, uint64_t *value);
+/// reads count MSRs of CPU cpu, whose numbers are in the msrs array,
+/// storing them in the corresponding elements of values.  The function
+/// returns true if all of them could be read and false otherwise.
+/// Like read_msr, it is only supported on Linux and requires root
+/// privileges.
+bool read_msrs(int cpu, const uint32_t *msrs, uint64_t *values, int count);
 /// writes the value specified by value to the MSR, specified by msr,
 /// of CPU cpu.  The function returns true if the value can be written
 /// and false otherwise.   This function is only supported on Linux and
@@ -624,6 +641,32 @@ extern uint32_t random32(void);
 extern uint64_t random64(void);
 /// Returns a random unsigned 128 bit integer.
 extern __uint128_t random128(void);
+/// Fills the array pointed to by dest with count random unsigned 32 bit
+/// integers. Produces the same values as count calls to random32(), but faster.
+extern void random32_array(uint32_t *dest, size_t count);
+/// Fills the array pointed to by dest with count random unsigned 64 bit
+/// integers. Produces the same values as count calls to random64(), but faster.
+extern void random64_array(uint64_t *dest, size_t count);
+/// Allocates at least size bytes of zeroed memory backed by huge pages where
+/// possible: hugetlbfs pages if any are reserved, otherwise transparent huge
+/// pages, otherwise regular pages. When called from a test thread, the
+/// memory is faulted in immediately on that thread's NUMA node. Meant for
+/// the large buffers that tests sweep in their main loop. Returns NULL on
+/// failure. Release the memory with hugepage_free().
+extern void *hugepage_alloc(size_t size);
+/// Releases memory allocated with hugepage_alloc(). The size must be the
+/// same that was passed to hugepage_alloc().
+extern void hugepage_free(void *ptr, size_t size);
+/// Allocates size bytes of zeroed memory for the use of test thread number
+/// thread, placed on the NUMA node of the logical processor that thread will
+/// run on, regardless of which thread first touches it. Meant for per-thread
+/// buffers allocated in test_init, so each thread's memory traffic stays
+/// node-local. Returns NULL on failure. Release the memory with
+/// per_thread_free().
+extern void *per_thread_alloc(int thread, size_t size);
+/// Releases memory allocated with per_thread_alloc(). The size must be the
+/// same that was passed to per_thread_alloc().
+extern void per_thread_free(void *ptr, size_t size);
 /// Sets each byte in the buffer pointed to by dest to a random value.
 /// The size of the buffer in bytes is provided by the n parameter.
 extern void *memset_random(void *dest, size_t n);
@@ -12,6 +12,10 @@
 
 #include <type_traits>
 
+#ifdef __x86_64__
+#  include <immintrin.h>
+#endif
+
 template <typename T, typename X>
 static T bit_cast(X src)
 {
@@ -51,8 +55,9 @@ template <typename T> static inline uint16_t ieee754_downconvert(T f)
         /* infinity or NaN */
         exp = 2 * OutputLimits::max_exponent - 1;
 #if defined(__i386__) || defined(__x86_64__)
-        /* x86 always quiets any SNaN, so do the same */
-        if (mant)
+        /* x86 always quiets any SNaN, so do the same (the NaN's payload
+           may be entirely in the bits we've discarded) */
+        if (v & MantissaMask)
             mant |= 1 << (OutputLimits::digits - 2);
 #endif
     } else if (exp >= OutputLimits::max_exponent) {
@@ -67,8 +72,8 @@ template <typename T> static inline uint16_t ieee754_downconvert(T f)
         mant >>= -(exp - (OutputLimits::min_exponent - 1));
         exp = 0;
     } else {
-        /* underflow or zero (including negative zero), make zero */
-        sign = exp = mant = 0;
+        /* underflow or zero, make zero of the same sign */
+        exp = mant = 0;
     }
 
     exp <<= OutputLimits::digits - 1;
@@ -103,8 +108,9 @@ template <typename T> static inline uint16_t to_bfloat16(T f)
     } else if (exp == 2 * InputLimits::max_exponent - 1) {
         uint16_t r = v >> 8 * (sizeof(T) - sizeof(BFloat16));
 #if defined(__i386__) || defined(__x86_64__)
-        /* x86 always quiets any SNaN, so do the same */
-        if (mant)
+        /* x86 always quiets any SNaN, so do the same (the NaN's payload
+           may be entirely in the bits we've discarded) */
+        if (v & MantissaMask)
             r |= 1 << (OutputLimits::digits - 2);
 #endif
         return r;
@@ -150,8 +156,9 @@ float fromfp16_emulated(Float16 f)
     if (__builtin_expect(!isnan(f.as_hex), 1))
         return decode_half(f.as_hex);
 
-    // preserve NaN's bit pattern
-    uint32_t p = f.as_hex & ~Float16::infinity().as_hex;
+    // preserve NaN's bit pattern and sign
+    uint32_t sign = f.as_hex & 0x8000;
+    uint32_t p = f.as_hex & ~Float16::neg_infinity().as_hex;
 
 #if defined(__i386__) || defined(__x86_64__)
     /* x86 always quiets any SNaN, so do the same */
@@ -160,6 +167,7 @@ float fromfp16_emulated(Float16 f)
 
     p <<= std::numeric_limits<float>::digits - Float16::digits;
     p |= bit_cast<uint32_t>(std::numeric_limits<float>::infinity());
+    p |= sign << 16;
     return bit_cast<float>(p);
 }
 
@@ -169,3 +177,104 @@ BFloat16 tobf16_emulated(float f)
     r.as_hex = to_bfloat16(f);
     return r;
 }
+
+// Array conversions. The vector paths use the same instructions as tofp16()
+// and fromfp16() do with F16C, which the emulated code matches bit-for-bit;
+// the remainder of each array is converted with the emulated functions. The
+// zero-masking AVX-512 forms avoid GCC's -Wmaybe-uninitialized on the
+// undefined pass-through operand of the unmasked ones.
+#ifdef __x86_64__
+__attribute__((target("avx512f")))
+static size_t tofp16_array_avx512(Float16 *dst, const float *src, size_t count)
+{
+    size_t i = 0;
+    for ( ; i + 16 <= count; i += 16) {
+        __m256i h = _mm512_maskz_cvtps_ph(0xffff, _mm512_loadu_ps(src + i), _MM_FROUND_TRUNC);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), h);
+    }
+    return i;
+}
+
+__attribute__((target("avx,f16c")))
+static size_t tofp16_array_f16c(Float16 *dst, const float *src, size_t count)
+{
+    size_t i = 0;
+    for ( ; i + 8 <= count; i += 8) {
+        __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TRUNC);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), h);
+    }
+    return i;
+}
+
+__attribute__((target("avx512f")))
+static size_t fromfp16_array_avx512(float *dst, const Float16 *src, size_t count)
+{
+    size_t i = 0;
+    for ( ; i + 16 <= count; i += 16) {
+        __m256i h = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        _mm512_storeu_ps(dst + i, _mm512_maskz_cvtph_ps(0xffff, h));
+    }
+    return i;
+}
+
+__attribute__((target("avx,f16c")))
+static size_t fromfp16_array_f16c(float *dst, const Float16 *src, size_t count)
+{
+    size_t i = 0;
+    for ( ; i + 8 <= count; i += 8) {
+        __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(h));
+    }
+    return i;
+}
+
+#if __GNUC__ > 9 || __clang_major__ >= 9
+__attribute__((target("avx512f,avx512bf16")))
+static size_t tobf16_array_avx512(BFloat16 *dst, const float *src, size_t count)
+{
+    size_t i = 0;
+    for ( ; i + 16 <= count; i += 16) {
+        __m256bh h = _mm512_cvtneps_pbh(_mm512_loadu_ps(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), reinterpret_cast<__m256i>(h));
+    }
+    return i;
+}
+#endif
+#endif // __x86_64__
+
+void tofp16_array(Float16 *dst, const float *src, size_t count)
+{
+    size_t i = 0;
+#ifdef __x86_64__
+    if (__builtin_cpu_supports("avx512f"))
+        i = tofp16_array_avx512(dst, src, count);
+    else if (__builtin_cpu_supports("f16c"))
+        i = tofp16_array_f16c(dst, src, count);
+#endif
+    for ( ; i < count; ++i)
+        dst[i] = tofp16_emulated(src[i]);
+}
+
+void fromfp16_array(float *dst, const Float16 *src, size_t count)
+{
+    size_t i = 0;
+#ifdef __x86_64__
+    if (__builtin_cpu_supports("avx512f"))
+        i = fromfp16_array_avx512(dst, src, count);
+    else if (__builtin_cpu_supports("f16c"))
+        i = fromfp16_array_f16c(dst, src, count);
+#endif
+    for ( ; i < count; ++i)
+        dst[i] = fromfp16_emulated(src[i]);
+}
+
+void tobf16_array(BFloat16 *dst, const float *src, size_t count)
+{
+    size_t i = 0;
+#if defined(__x86_64__) && (__GNUC__ > 9 || __clang_major__ >= 9)
+    if (__builtin_cpu_supports("avx512bf16"))
+        i = tobf16_array_avx512(dst, src, count);
+#endif
+    for ( ; i < count; ++i)
+        dst[i] = tobf16_emulated(src[i]);
+}
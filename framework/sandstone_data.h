@@ -111,6 +111,11 @@ extern Float16 tofp16_emulated(float f);
 extern float fromfp16_emulated(Float16 f);
 extern BFloat16 tobf16_emulated(float f);
 
+/* convert count elements, using the CPU's conversion instructions if available */
+extern void tofp16_array(Float16 *dst, const float *src, size_t count);
+extern void fromfp16_array(float *dst, const Float16 *src, size_t count);
+extern void tobf16_array(BFloat16 *dst, const float *src, size_t count);
+
 static inline Float16 tofp16(float f)
 {
 #ifdef __F16C__
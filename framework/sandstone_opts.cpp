@@ -28,6 +28,7 @@ enum {
     two_min_option,
     five_min_option,
 
+    binary_log_option,
     cpuset_option,
     disable_option,
     dump_cpu_info_option,
@@ -35,12 +36,15 @@ enum {
     gdb_server_option,
     ignore_mce_errors_option,
     ignore_os_errors_option,
+    huge_pages_option,
     ignore_unknown_tests_option,
     include_optional_option,
     inject_idle_option,
     is_asan_option,
     is_debug_option,
     force_test_time_option,
+    fracture_cache_option,
+    frequency_settle_timeout_option,
     test_knob_option,
     longer_runtime_option,
     max_concurrent_threads_option,
@@ -58,6 +62,7 @@ enum {
     on_crash_option,
     on_hang_option,
     output_format_option,
+    perf_counters_option,
     quality_option,
     quick_run_option,
     raw_list_tests,
@@ -86,6 +91,7 @@ enum {
     vary_frequency,
     vary_uncore_frequency,
     version_option,
+    weighted_schedule_option,
     weighted_testrun_option,
 };
 
@@ -127,6 +133,11 @@ Common command-line options are:
      limit to the number of loop iterations.  This special value can be
      used to disable test fracturing.  When specified tests will not be
      fractured and their execution will be time limited.
+ --fracture-cache=<file>
+     Remembers in <file> how long one loop of each automatically fractured
+     test took on this CPU model and CPU count, so later runs size the first
+     fracture from it instead of ramping up from 40 loops.  The file is
+     created if it does not exist and may be shared between machines.
  --cpuset=<set>
      Selects the CPUs to run tests on. The <set> option may be a comma-separated
      list of either plain numbers that select based on the system's logical
@@ -146,6 +157,11 @@ Common command-line options are:
      Ignore unknown tests listed on --enable and --disable.
  -h, --help
      Print help.
+ --huge-pages
+     Back the large memory blocks (2 MB or more) that tests allocate with
+     transparent huge pages, so the tests don't measure TLB misses they were
+     not meant to measure.  Has no effect if the system does not support
+     transparent huge pages.
  -l, --list
      Lists the tests and groups, with their descriptions, and exits.
  --list-tests
@@ -169,6 +185,10 @@ Common command-line options are:
  -o, --output-log <FILE>
      Place all logging information in <FILE>.  By default, a file name is
      auto-generated by the program.  Use -o /dev/null to suppress creation of any file.
+ --binary-log=<FILE>
+     With YAML output, append each thread's messages to <FILE> in a compact
+     binary format instead of formatting them into the log after every test.
+     Use scripts/binlog2yaml.py to convert <FILE> to YAML or TAP afterwards.
  -s <STATE>, --rng-state=<STATE>
      Specify the random generator state to reload. The seed is in the form:
        Engine:engine-specific-data
@@ -185,9 +205,22 @@ Common command-line options are:
  --test-list-file <file path>
      Specifies the tests to run in a text file.  This will run the tests
      in the order they appear in the file and also allows you to vary the
-     individual test durations.  See the User Guide for details.
+     individual test durations.  Each line is "test[:duration[:weight]]";
+     the weight is only used by --weighted-schedule.  See the User Guide
+     for details.
  --test-list-randomize
      Randomizes the order in which tests are executed.
+ --frequency-settle-timeout=<time>
+     With --vary-frequency, wait after each frequency change until a few
+     CPUs run within 5%% of the new frequency, for up to <time>, before
+     starting the test. Requires access to the APERF and MPERF MSRs.
+ --weighted-schedule
+     Instead of running the tests in list order, repeatedly picks the test
+     whose next run adds the most expected coverage per CPU-second, using
+     the weights from the test list file (default 1) and assuming repeated
+     runs of the same test are worth less each time.  Over a long run, each
+     test gets a share of the time proportional to its weight.  The time
+     budget is -T, or the time a regular pass through the list would take.
  --test-delay <time in ms>
      Delay between individual test executions in milliseconds.
   -Y, --yaml [<indentation>]
@@ -456,6 +489,7 @@ int parse_cmdline(int argc, char** argv, SandstoneApplication* app, ParsedCmdLin
         { "5min", no_argument, nullptr, five_min_option },
         { "alpha", no_argument, &app->requested_quality, int(TEST_QUALITY_SKIP) },
         { "beta", no_argument, &app->requested_quality, int(TEST_QUALITY_BETA) },
+        { "binary-log", required_argument, nullptr, binary_log_option },
         { "cpuset", required_argument, nullptr, cpuset_option },
         { "disable", required_argument, nullptr, disable_option },
         { "dump-cpu-info", no_argument, nullptr, dump_cpu_info_option },
@@ -464,6 +498,7 @@ int parse_cmdline(int argc, char** argv, SandstoneApplication* app, ParsedCmdLin
         { "fatal-skips", no_argument, nullptr, fatal_skips_option },
         { "fork-mode", required_argument, nullptr, 'f' },
         { "help", no_argument, nullptr, 'h' },
+        { "huge-pages", no_argument, nullptr, huge_pages_option },
         { "ignore-mce-errors", no_argument, nullptr, ignore_mce_errors_option },
         { "ignore-os-errors", no_argument, nullptr, ignore_os_errors_option },
         { "ignore-timeout", no_argument, nullptr, ignore_os_errors_option },
@@ -492,6 +527,7 @@ int parse_cmdline(int argc, char** argv, SandstoneApplication* app, ParsedCmdLin
         { "on-hang", required_argument, nullptr, on_hang_option },
         { "output-format", required_argument, nullptr, output_format_option},
         { "output-log", required_argument, nullptr, 'o' },
+        { "perf-counters", no_argument, nullptr, perf_counters_option },
         { "quality", required_argument, nullptr, quality_option },
         { "quick", no_argument, nullptr, quick_run_option },
         { "quiet", no_argument, nullptr, 'q' },
@@ -512,6 +548,8 @@ int parse_cmdline(int argc, char** argv, SandstoneApplication* app, ParsedCmdLin
         { "test-list-randomize", no_argument, nullptr, test_list_randomize_option },
         { "test-time", required_argument, nullptr, 't' },   // repeated below
         { "force-test-time", no_argument, nullptr, force_test_time_option },
+        { "fracture-cache", required_argument, nullptr, fracture_cache_option },
+        { "frequency-settle-timeout", required_argument, nullptr, frequency_settle_timeout_option },
         { "test-option", required_argument, nullptr, 'O'},
         { "threads", required_argument, nullptr, 'n' },
         { "time", required_argument, nullptr, 't' },        // repeated above
@@ -524,6 +562,7 @@ int parse_cmdline(int argc, char** argv, SandstoneApplication* app, ParsedCmdLin
         { "vary-uncore-frequency", no_argument, nullptr, vary_uncore_frequency},
         { "verbose", no_argument, nullptr, 'v' },
         { "version", no_argument, nullptr, version_option },
+        { "weighted-schedule", no_argument, nullptr, weighted_schedule_option },
         { "weighted-testrun-type", required_argument, nullptr, weighted_testrun_option },
         { "yaml", optional_argument, nullptr, 'Y' },
 
@@ -552,6 +591,7 @@ int parse_cmdline(int argc, char** argv, SandstoneApplication* app, ParsedCmdLin
                 opts.enabled_tests.push_back(optarg);
                 break;
             case 'f':
+                app->use_child_pool = false;
                 if (strcmp(optarg, "no") == 0 || strcmp(optarg, "no-fork") == 0) {
                     app->fork_mode = SandstoneApplication::no_fork;
                 } else if (!strcmp(optarg, "exec")) {
@@ -559,6 +599,11 @@ int parse_cmdline(int argc, char** argv, SandstoneApplication* app, ParsedCmdLin
 #ifndef _WIN32
                 } else if (strcmp(optarg, "yes") == 0 || strcmp(optarg, "each-test") == 0) {
                     app->fork_mode = SandstoneApplication::fork_each_test;
+#endif
+#ifdef __linux__
+                } else if (strcmp(optarg, "pool") == 0) {
+                    app->fork_mode = SandstoneApplication::fork_each_test;
+                    app->use_child_pool = true;
 #endif
                 } else {
                     fprintf(stderr, "%s: unknown option to -f: %s\n", argv[0], optarg);
@@ -629,6 +674,12 @@ int parse_cmdline(int argc, char** argv, SandstoneApplication* app, ParsedCmdLin
             case force_test_time_option: /* overrides max and min duration specified by the test */
                 app->force_test_time = true;
                 break;
+            case binary_log_option:
+                app->binary_log_path = optarg;
+                break;
+            case fracture_cache_option:
+                app->fracture_cache_path = optarg;
+                break;
             case 'T':
                 if (strcmp(optarg, "forever") == 0) {
                     app->endtime = MonotonicTimePoint::max();
@@ -789,6 +840,12 @@ int parse_cmdline(int argc, char** argv, SandstoneApplication* app, ParsedCmdLin
             case ud_on_failure_option:
                 app->shmem->ud_on_failure = true;
                 break;
+            case perf_counters_option:
+                app->shmem->perf_counters = true;
+                break;
+            case huge_pages_option:
+                app->shmem->huge_pages = true;
+                break;
             case use_builtin_test_list_option:
                 if (!SandstoneConfig::HasBuiltinTestList) {
                     fprintf(stderr, "%s: --use-builtin-test-list specified but this build does not "
@@ -841,6 +898,9 @@ int parse_cmdline(int argc, char** argv, SandstoneApplication* app, ParsedCmdLin
             case test_list_randomize_option:
                 opts.test_set_config.randomize = true;
                 break;
+            case weighted_schedule_option:
+                app->weighted_schedule = true;
+                break;
 
             case max_logdata_option: {
                 app->shmem->max_logdata_per_thread = ParseIntArgument<unsigned>{
@@ -872,6 +932,14 @@ int parse_cmdline(int argc, char** argv, SandstoneApplication* app, ParsedCmdLin
                 app->vary_frequency_mode = true;
                 break;
 
+            case frequency_settle_timeout_option:
+                if (!FrequencyManager::FrequencyManagerWorks) {
+                    fprintf(stderr, "%s: --frequency-settle-timeout works only on Linux\n", program_invocation_name);
+                    return EX_USAGE;
+                }
+                app->frequency_settle_timeout = string_to_millisecs(optarg);
+                break;
+
             case vary_uncore_frequency:
                 if (!FrequencyManager::FrequencyManagerWorks) {
                     fprintf(stderr, "%s: --vary-uncore-frequency works only on Linux\n", program_invocation_name);
@@ -27,6 +27,7 @@
 #include <sandstone.h>
 
 #ifdef __cplusplus
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <memory>
@@ -108,6 +109,9 @@ bool splitlock_enforcement_enabled(void);
 struct mmap_region mmap_file(int fd);
 void munmap_file(struct mmap_region r);
 
+/* malloc.cpp (hugepage_region.c has a no-op fallback) */
+void malloc_enable_huge_pages(void);
+
 /* memfpt.c / cpp */
 size_t memfpt_current_high_water_mark(void);
 
@@ -117,6 +121,7 @@ int open_memfd(enum MemfdCloexecFlag);
 
 #ifdef __cplusplus
 }
+struct MemcmpMismatchMap;
 struct RandomEngineWrapper;
 struct RandomEngineDeleter { void operator()(RandomEngineWrapper *) const; };
 
@@ -179,14 +184,43 @@ inline int simple_getopt(int argc, char **argv, struct option *options, int *opt
     return getopt_long(argc, argv, cached_short_opts.c_str(), options, optind);
 }
 
+/* hardware counter deltas collected around a test run (see --perf-counters) */
+struct PerfCounterSet
+{
+    enum Counter : uint8_t {
+        Cycles,
+        Instructions,
+        BranchMisses,
+        L1DMisses,
+        LLCMisses,
+        CounterCount
+    };
+    static constexpr uint64_t NotAvailable = UINT64_MAX;
+    uint64_t values[CounterCount];
+    bool multiplexed;           // values were scaled up from a partial run
+
+    void init()
+    {
+        std::fill(std::begin(values), std::end(values), NotAvailable);
+        multiplexed = false;
+    }
+};
+
 namespace PerThreadData {
+/* size of each thread's log buffer in the shared memory (see logging.cpp) */
+static constexpr unsigned LogBufferSize = 16 * 1024;
+
 struct Common
 {
     std::atomic<ThreadState> thread_state;
 
-    /* file descriptor for logging */
+    /* file descriptor for logging (used when the log buffer overflows) */
     int log_fd;
 
+    /* offset from sApp->shmem to this thread's log buffer and how much of it is used */
+    uint32_t log_buffer_offset;
+    std::atomic<unsigned> log_buffer_used;
+
     /* Records number of messages logged per thread of each test */
     std::atomic<int> messages_logged;
 
@@ -211,6 +245,15 @@ struct Common
 struct alignas(64) Main : Common
 {
     CpuRange cpu_range;
+
+    /* set by the first test thread that finds the test's time is up */
+    std::atomic<bool> test_deadline_expired;
+
+    void init()
+    {
+        Common::init();
+        test_deadline_expired.store(false, std::memory_order_relaxed);
+    }
 };
 
 struct alignas(64) Test : Common
@@ -222,14 +265,22 @@ struct alignas(64) Test : Common
     /* Thread's effective CPU frequency during execution */
     double effective_freq_mhz;
 
+    /* Time spent in the test's run function */
+    Duration run_duration;
+
     /* Thread ID */
     std::atomic<tid_t> tid;
 
+    /* perf_event counter deltas, if --perf-counters was given */
+    PerfCounterSet perf_counters;
+
     void init()
     {
         Common::init();
         inner_loop_count = inner_loop_count_at_fail = 0;
         effective_freq_mhz = 0.0;
+        run_duration = {};
+        perf_counters.init();
     }
 };
 } // namespace PerThreadData
@@ -346,6 +397,8 @@ struct SandstoneApplication : public InterruptMonitor, public test_the_test_data
     static constexpr int DefaultQualityLevel = int(TEST_QUALITY_PROD);
     int requested_quality = DefaultQualityLevel;
     std::string file_log_path;
+    std::string fracture_cache_path;    // --fracture-cache
+    std::string binary_log_path;        // --binary-log
     const char *syslog_ident = nullptr;
 
     bool fatal_skips = false;
@@ -356,12 +409,15 @@ struct SandstoneApplication : public InterruptMonitor, public test_the_test_data
 #else
             fork_each_test;
 #endif
+    bool use_child_pool = false;        // fork_each_test with pre-forked children
     bool ignore_mce_errors = false;
     bool ignore_os_errors = false;
     bool force_test_time = false;
+    bool weighted_schedule = false;     // --weighted-schedule
     bool service_background_scan = false;
     bool vary_frequency_mode = false;
     bool vary_uncore_frequency_mode = false;
+    ShortDuration frequency_settle_timeout = {};    // --frequency-settle-timeout
     int inject_idle = 0;
     static constexpr int MaxRetestCount = sizeof(PerCpuFailures::value_type) * 8;
     int retest_count = 10;
@@ -443,10 +499,13 @@ struct SandstoneApplication::SharedMemory
 
     // test execution
     MonotonicTimePoint current_test_endtime = {};
+    uint64_t current_test_tsc_endtime = 0;  // TSC before which the end time can't have passed (0 = unknown)
     int current_max_loop_count = 0;
     std::chrono::duration<int, std::micro> current_test_sleep_duration = {};
     bool selftest = false;
     bool ud_on_failure = false;
+    bool perf_counters = false;
+    bool huge_pages = false;
     bool use_strict_runtime = false;
 
     // logging parameters
@@ -628,7 +687,7 @@ static_assert(std::is_trivially_destructible_v<SandstoneApplication::SharedMemor
 /* child_debug.cpp */
 void debug_init_child(void);
 void debug_init_global(const char *on_hang_arg, const char *on_crash_arg);
-void debug_crashed_child(std::span<const pid_t> children);
+std::vector<int> debug_crashed_child(std::span<const pid_t> children);
 void debug_hung_child(pid_t child, std::span<const pid_t> children);
 
 /* logging.cpp */
@@ -642,7 +701,7 @@ void logging_restricted(int level, const char *fmt, ...);
 void logging_printf(int level, const char *msg, ...) ATTRIBUTE_PRINTF(2, 3);
 void logging_mark_thread_failed(int thread_num);
 void logging_report_mismatched_data(enum DataType type, const uint8_t *actual, const uint8_t *expected,
-                                    size_t size, ptrdiff_t offset, const char *fmt, va_list);
+                                    size_t size, const MemcmpMismatchMap &mismatches, const char *fmt, va_list);
 void logging_print_header(int argc, char **argv, ShortDuration test_duration, ShortDuration test_timeout);
 void logging_print_iteration_start();
 void logging_print_footer();
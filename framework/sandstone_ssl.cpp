@@ -6,6 +6,7 @@
 #include "sandstone_ssl.h"
 
 #include <algorithm>
+#include <vector>
 
 #ifdef _WIN32
 #  include <windows.h>
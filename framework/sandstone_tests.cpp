@@ -13,6 +13,7 @@
 #include "sandstone_p.h"
 #include "sandstone_tests.h"
 #include "sandstone_chrono.h"
+#include "test_list_parser.h"
 
 #if !defined(__linux__) || !defined(__x86_64__)
 // no MCE test outside Linux
@@ -143,26 +144,6 @@ int SandstoneTestSet::remove(const char *name)
     return res;
 }
 
-static inline bool is_ignored(char c) {
-    switch (c) {
-        case ' ':
-        case '\t':
-            return true;
-        default:
-            return false;
-    }
-}
-
-static inline bool is_terminator(char c) {
-    switch (c) {
-        case '#':
-        case ':':
-            return true;
-        default:
-            return false;
-    }
-}
-
 enum line_type {
     LT_VALID_TEST,
     LT_TEST_NOT_FOUND,
@@ -172,32 +153,22 @@ enum line_type {
 
 static line_type parse_test_list_line(std::string line, SandstoneTestSet *test_set, struct test_cfg_info &ti)
 {
-    std::vector<std::string> tokens;
-    auto it = line.begin();
-    while (is_ignored(*it)) ++it;
-    if (*it == '#' || it == line.end()) return LT_EMPTY;
-    for (; ; ++it) {
-        auto cit = it;
-        /* scroll while it's valid token contents: till end of line, a
-         * terminator, or a space. */
-        while (cit != line.end() && !is_terminator(*cit) && !is_ignored(*cit)) ++cit;
-        auto tend = cit;
-        while (cit != line.end() && is_ignored(*cit)) ++cit;
-        if (cit != line.end() && !is_terminator(*cit)) return LT_SYNTAX_ERROR;
-        tokens.emplace_back(it, tend);
-        if (cit == line.end() || *cit == '#') break;
-        it = cit;
+    TestListLine fields;
+    switch (parse_test_list_line(line, fields)) {
+    case TestListLine::Valid:
+        break;
+    case TestListLine::Empty:
+        return LT_EMPTY;
+    case TestListLine::SyntaxError:
+        return LT_SYNTAX_ERROR;
     }
-    if (!tokens.size()) __builtin_unreachable();
-    if (tokens.size() > 2) return LT_SYNTAX_ERROR;
-    SandstoneTestSet::TestSet set = test_set->lookup(tokens[0].c_str());
+
+    SandstoneTestSet::TestSet set = test_set->lookup(fields.test_id.c_str());
     if (!set.size()) return LT_TEST_NOT_FOUND;
     if (set.size() != 1) return LT_SYNTAX_ERROR; /* Artificially do not allow specifying wildcards or groups in the list file. */
     ti.test = set[0];
-    if (tokens.size() == 2) {
-        if (tokens[1].size() && strcasecmp(tokens[1].c_str(), "default") != 0)
-            ti.duration = string_to_millisecs(tokens[1]);
-    }
+    ti.duration = fields.duration;
+    ti.weight = fields.weight;
     return LT_VALID_TEST;
 }
 
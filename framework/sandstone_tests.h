@@ -47,6 +47,7 @@ struct test_cfg_info {
     struct test *test = nullptr;
     test_status status = not_found;
     ShortDuration duration = ShortDuration::zero();
+    double weight = 1.0;        /* for --weighted-schedule */
 
     /* implicit */ test_cfg_info(struct test *test = nullptr) : test(test) {}
 };
@@ -92,6 +93,10 @@ public:
 
     EnabledTestList::iterator end() noexcept { return test_set.end(); }
 
+    /* the enabled tests in list order (never shuffles) */
+    std::span<test_cfg_info> entries() noexcept { return test_set; }
+    EnabledTestList::iterator at(size_t idx) noexcept { return test_set.begin() + idx; }
+
     int remove(const char *name);
     int remove(const struct test *t);
 
@@ -6,6 +6,7 @@
 #include "sandstone_thread.h"
 #include "sandstone_p.h"
 
+#include "futex.h"
 #include "gettid.h"
 
 #include <sys/mman.h>
@@ -106,3 +107,121 @@ uintptr_t SandstoneTestThread::join()
     pthread_join(thread, &result);
     return uintptr_t(result);
 }
+
+namespace {
+struct TestThreadPool
+{
+    enum WorkerState : int { NotStarted, Running, Exited };
+    struct Worker {
+        SandstoneTestThread thread;
+        std::atomic<int> state = NotStarted;
+
+        // run() increments this to hand the worker a job; the worker runs it
+        // once it differs from the last value it served. Each worker has its
+        // own, so run() only wakes the workers it needs. (futex_wait() and
+        // futex_wake_one() operate on ints)
+        std::atomic<int> generation = 0;
+        int served = 0;
+    };
+
+    std::atomic<int> pending = 0;
+    SandstoneTestThread::RunnerFunction *job = nullptr;     // stable until pending is 0
+    std::unique_ptr<Worker[]> workers;
+
+    static TestThreadPool &instance()
+    {
+        static TestThreadPool pool;
+        return pool;
+    }
+
+    static uintptr_t worker_main(int n);
+    void reap_exited_workers();
+};
+} // unnamed namespace
+
+uintptr_t TestThreadPool::worker_main(int n)
+{
+    TestThreadPool &pool = instance();
+    Worker &self = pool.workers[n];
+
+    for (;;) {
+        // park until we're handed the next job
+        int g;
+        while ((g = self.generation.load(std::memory_order_acquire)) == self.served)
+            futex_wait(&self.generation, g);
+        self.served = g;
+
+        // if the test exits the thread (pthread_cancel()), the unwinding
+        // will still let our caller know we're done
+        auto finish = scopeExit([&] {
+            if (pool.pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                futex_wake_all(&pool.pending);
+        });
+        auto mark_exited = scopeExit([&] {
+            self.state.store(Exited, std::memory_order_relaxed);
+        });
+
+        ::thread_num = n;
+        pool.job(n);
+        mark_exited.dismiss();
+    }
+}
+
+void TestThreadPool::reap_exited_workers()
+{
+    for (int i = 0; i < num_cpus(); ++i) {
+        Worker &w = workers[i];
+        if (w.state.load(std::memory_order_relaxed) != Exited)
+            continue;
+        w.thread.join();
+        w.served = w.generation.load(std::memory_order_relaxed);
+        w.state.store(NotStarted, std::memory_order_relaxed);
+    }
+}
+
+void SandstoneTestThreadPool::run(SandstoneTestThread::RunnerFunction *f, int count)
+{
+#ifndef _WIN32
+    // On Windows, report_fail() uses _endthread() so we can't tell that the
+    // thread has exited.
+    constexpr bool UsePool = FutexAvailable;
+#else
+    constexpr bool UsePool = false;
+#endif
+    assert(count <= num_cpus());
+    if constexpr (!UsePool) {
+        SandstoneTestThread thr[count];     // NOLINT: -Wvla
+        for (int i = 0; i < count; i++)
+            thr[i].start(f, i);
+        for (int i = 0; i < count; i++)
+            thr[i].join();
+        return;
+    }
+
+    TestThreadPool &pool = TestThreadPool::instance();
+    if (!pool.workers)
+        pool.workers.reset(new TestThreadPool::Worker[num_cpus()]);
+
+    pool.job = f;
+    pool.pending.store(count, std::memory_order_relaxed);
+
+    // hand the job to the first count workers, waking up the parked ones and
+    // starting any that haven't been started yet or were replaced
+    for (int i = 0; i < count; ++i) {
+        TestThreadPool::Worker &w = pool.workers[i];
+        w.generation.fetch_add(1, std::memory_order_release);
+        if (w.state.load(std::memory_order_relaxed) != TestThreadPool::NotStarted) {
+            futex_wake_one(&w.generation);
+            continue;
+        }
+        w.state.store(TestThreadPool::Running, std::memory_order_relaxed);
+        w.thread.start(TestThreadPool::worker_main, i);
+    }
+
+    /* wait for threads to end */
+    int p;
+    while ((p = pool.pending.load(std::memory_order_acquire)) != 0)
+        futex_wait(&pool.pending, p);
+
+    pool.reap_exited_workers();
+}
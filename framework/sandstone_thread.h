@@ -22,4 +22,16 @@ struct SandstoneTestThread
     int thread_num;
 };
 
+// Pool of test threads that are kept alive (and parked) between calls to
+// run(), so we don't pay for the thread creation and pinning every time.
+// Threads that exit because of pthread_cancel() (see report_fail()) are
+// replaced on the next call. The threads are only reused when the same
+// process runs more than one test (--fork-mode=no); a child started for a
+// single test runs it once.
+struct SandstoneTestThreadPool
+{
+    // runs f(n) for each n in [0, count) in parallel and waits for all of them
+    static void run(SandstoneTestThread::RunnerFunction *f, int count);
+};
+
 #endif // SANDSTONE_THREAD
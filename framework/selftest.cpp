@@ -23,6 +23,9 @@
 #ifdef __unix__
 #include <sys/wait.h>
 #endif
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
 
 #include "sandstone.h"
 #ifndef _WIN32
@@ -983,6 +986,73 @@ static int selftest_inject_idle(struct test *test, int cpu)
     return EXIT_SUCCESS;
 }
 
+static int selftest_memset_random_bench_run(struct test *test, int cpu)
+{
+    // large enough to not fit in the L2 cache
+    static constexpr size_t BufferSize = 4 * 1024 * 1024;
+    auto buf = std::make_unique<uint8_t[]>(BufferSize);
+    uint64_t total = 0;
+
+    auto start = steady_clock::now();
+    TEST_LOOP(test, 1) {
+        memset_random(buf.get(), BufferSize);
+        total += BufferSize;
+    }
+    duration<double> elapsed = steady_clock::now() - start;
+
+    std::string seed = random_format_seed();
+    log_info("%s: %.2f GB/s", seed.substr(0, seed.find(':')).c_str(),
+             total / elapsed.count() / 1e9);
+    return EXIT_SUCCESS;
+}
+
+static int selftest_malloc_bench_init(struct test *test)
+{
+    // 64 MB in total, split among the threads, unless overridden
+    size_t block_size = get_testspecific_knob_value_uint(test, "BlockSize", 64 * 1024 * 1024 / num_cpus());
+    block_size = ROUND_UP_TO_PAGE(std::max<size_t>(block_size, 1024 * 1024));
+#ifdef M_MMAP_THRESHOLD
+    // glibc raises the threshold past each mmap()ed block we free, which
+    // would move the following allocations to the heap: pin it. There's no
+    // way to undo that, so only do it if this process goes away after the
+    // test; with --fork-mode=no, blocks under 32 MB may come from the heap.
+    if (sApp->current_fork_mode() != SandstoneApplication::no_fork)
+        mallopt(M_MMAP_THRESHOLD, std::min<size_t>(block_size, 32 * 1024 * 1024));
+#endif
+    test->data = reinterpret_cast<void *>(uintptr_t(block_size));
+    return EXIT_SUCCESS;
+}
+
+static int selftest_malloc_bench_run(struct test *test, int cpu)
+{
+    const size_t BlockSize = uintptr_t(test->data);
+    duration<double> alloc_only = {}, alloc_and_zero = {};
+    uint64_t total = 0;
+
+    auto allocate_and_fill = [BlockSize](bool zero) {
+        void *ptr = malloc(BlockSize);
+        if (zero)
+            memset(ptr, 0, BlockSize);      // what the allocator used to do
+        memset(ptr, 0xa5, BlockSize);
+        __asm__ volatile ("" : : "r" (ptr) : "memory");
+        free(ptr);
+    };
+
+    TEST_LOOP(test, 1) {
+        auto start = steady_clock::now();
+        allocate_and_fill(false);
+        auto middle = steady_clock::now();
+        allocate_and_fill(true);
+        alloc_and_zero += steady_clock::now() - middle;
+        alloc_only += middle - start;
+        total += BlockSize;
+    }
+
+    log_info("malloc + fill: %.2f GB/s; malloc + zero + fill: %.2f GB/s",
+             total / alloc_only.count() / 1e9, total / alloc_and_zero.count() / 1e9);
+    return EXIT_SUCCESS;
+}
+
 const static test_group group_positive = {
     .id = "positive",
     .description = "Self-tests that succeed (positive results)"
@@ -1731,6 +1801,21 @@ FOREACH_DATATYPE(DATACOMPARE_TEST)
     .flags = test_type_kvm,
 },
 #endif // __linux__
+{
+    .id = "selftest_memset_random_bench",
+    .description = "Measures memset_random() throughput for the selected random engine (use -s to select)",
+    .groups = DECLARE_TEST_GROUPS(&group_positive),
+    .test_run = selftest_memset_random_bench_run,
+    .quality_level = TEST_QUALITY_OPTIONAL,
+},
+{
+    .id = "selftest_malloc_bench",
+    .description = "Measures the throughput of allocating and filling large blocks of memory",
+    .groups = DECLARE_TEST_GROUPS(&group_positive),
+    .test_init = selftest_malloc_bench_init,
+    .test_run = selftest_malloc_bench_run,
+    .quality_level = TEST_QUALITY_OPTIONAL,
+},
 {
     .id = "selftest_inject_idle",
     .description = "Verifies idle injection has no impact on test run time",
@@ -0,0 +1 @@
+#include "../generic/perf_counters.hpp"
@@ -11,6 +11,12 @@ bool read_msr(int cpu, uint32_t msr, uint64_t * value)
     return false;
 }
 
+bool read_msrs(int cpu, const uint32_t *msrs, uint64_t *values, int count)
+{
+    errno = ENOSYS;
+    return false;
+}
+
 bool write_msr(int cpu, uint32_t msr, uint64_t value)
 {
     errno = ENOSYS;
@@ -0,0 +1,22 @@
+/*
+ * Copyright 2025 Intel Corporation.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "sandstone_p.h"
+#include <sys/mman.h>
+
+void *per_thread_alloc(int thread, size_t size)
+{
+    // NUMA placement not supported, so this is just a page-aligned allocation
+    if (size == 0)
+        return NULL;
+    void *ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return ptr == MAP_FAILED ? NULL : ptr;
+}
+
+void per_thread_free(void *ptr, size_t size)
+{
+    if (ptr)
+        munmap(ptr, size);
+}
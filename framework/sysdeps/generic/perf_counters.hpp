@@ -0,0 +1,22 @@
+/*
+ * Copyright 2025 Intel Corporation.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef GENERIC_PERF_COUNTERS_HPP
+#define GENERIC_PERF_COUNTERS_HPP
+
+#include "sandstone_p.h"
+
+/*
+ * The "do nothing" placeholder version: all counters are reported as
+ * unavailable.
+ */
+class PerfCounterGroup
+{
+public:
+    void start() { }
+    void stop(PerfCounterSet *result) { result->init(); }
+};
+
+#endif //GENERIC_PERF_COUNTERS_HPP
@@ -10,3 +10,10 @@ uint64_t retrieve_physical_address(const volatile void *ptr)
     // not suppotred
     return 0;
 }
+
+size_t retrieve_physical_address_range(const volatile void *ptr, size_t len, uint64_t *addresses,
+                                       size_t count)
+{
+    // not supported
+    return 0;
+}
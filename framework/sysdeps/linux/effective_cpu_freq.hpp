@@ -11,6 +11,7 @@
 #else
 
 #include "sandstone_p.h"
+#include <iterator>
 #include <limits>
 #include <x86intrin.h>
 
@@ -26,11 +27,14 @@ public:
         ns = MonotonicTimePoint::clock::now();
         tsc = __rdtscp(&tsc_aux);
 
-        if (!read_msr(cpu_number, APERF_MSR, &aperf))
-            aperf = 0;
-
-        if (!read_msr(cpu_number, MPERF_MSR, &mperf))
-            mperf = 0;
+        static constexpr uint32_t msrs[] = { APERF_MSR, MPERF_MSR };
+        uint64_t values[std::size(msrs)];
+        if (read_msrs(cpu_number, msrs, values, std::size(msrs))) {
+            aperf = values[0];
+            mperf = values[1];
+        } else {
+            aperf = mperf = 0;
+        }
     }
 
     static double EffectiveFrequencyMHz(const CPUTimeFreqStamp& before, const CPUTimeFreqStamp& after)
@@ -6,6 +6,12 @@
 #include <interrupt_monitor.hpp>
 #include <sandstone_p.h>
 
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <string_view>
+
 constexpr const char * const proc_interrupts_file = "/proc/interrupts";
 
 static bool is_kernel_blank(char c)
@@ -60,68 +66,121 @@ static const std::vector<int> &parse_header(char *line, ssize_t nread)
     return cache.result;
 }
 
-// this function reads the interrupts file and returns a list of integers corresponding
-// to the contents of the line that matches the input header prefix, for example "MCE:"
-std::vector<uint32_t> InterruptMonitor::get_interrupt_counts(InterruptType type)
+namespace {
+// /proc/interrupts is kept open and re-read with pread() into a buffer that
+// is only ever grown, so sampling it doesn't allocate or reopen anything.
+struct ProcInterruptsFile
 {
-    static_assert(InterruptMonitorWorks);
-    static AutoClosingFile f = { fopen(proc_interrupts_file, "r") };
-
-    const char *hdr = [type] {
-        switch (type) {
-        case MCE:
-            return "MCE:";
-        case Thermal:
-            return "TRM:";
+    int fd = open(proc_interrupts_file, O_RDONLY | O_CLOEXEC);
+    std::vector<char> buffer = std::vector<char>(16 * 1024);
+
+    // offsets where each row was found in the previous read
+    size_t row_offsets[2] = {};
+
+    ~ProcInterruptsFile()
+    {
+        if (fd >= 0)
+            close(fd);
+    }
+
+    // returns the file contents; the buffer is NUL-terminated
+    std::string_view read()
+    {
+        size_t total = 0;
+        for (;;) {
+            if (buffer.size() - total < 2)
+                buffer.resize(buffer.size() * 2);
+            ssize_t n = pread(fd, buffer.data() + total, buffer.size() - total - 1, total);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n < 0)
+                return {};
+            if (n == 0)
+                break;
+            total += n;
         }
-        assert(false && "Should not have reached here");
-        __builtin_unreachable();
-        return static_cast<const char *>(nullptr);
-    }();
+        buffer[total] = '\0';
+        return { buffer.data(), total };
+    }
+};
+} // unnamed namespace
 
-    std::vector<uint32_t> result;
-    if (!f)
-        return result;
+// finds the line whose prefix is hdr (for example "MCE:"), trying first where
+// it was the last time, and returns a pointer to just past the prefix
+static char *find_row(std::string_view contents, size_t &cached_offset, const char *hdr)
+{
+    auto matches = [&](size_t offset) -> char * {
+        char *ptr = skip_to_non_blank(const_cast<char *>(contents.data()) + offset);
+        if (strncmp(ptr, hdr, strlen(hdr)) != 0)
+            return nullptr;
+        return ptr + strlen(hdr);
+    };
 
-    char *line = nullptr;
-    size_t len = 0;
-    auto free_line = scopeExit([&] { free(line); });
+    if (cached_offset && cached_offset < contents.size() && contents[cached_offset - 1] == '\n') {
+        if (char *ptr = matches(cached_offset))
+            return ptr;
+    }
 
-    // read the header and create the CPU mapping
-    ssize_t nread = getline(&line, &len, f);
-    const std::vector<int> &cpu_mapping = parse_header(line, nread);
-    if (cpu_mapping.size() == 0) {
-        // failed to parse the header!
-        fclose(f);
-        f.f = nullptr;
-        return result;
+    for (size_t offset = contents.find('\n'); offset != std::string_view::npos;
+         offset = contents.find('\n', offset)) {
+        ++offset;
+        if (char *ptr = matches(offset)) {
+            cached_offset = offset;
+            return ptr;
+        }
     }
+    cached_offset = 0;
+    return nullptr;
+}
 
+static void parse_row(char *ptr, const std::vector<int> &cpu_mapping, std::vector<uint32_t> &result)
+{
     // static code analyzers: we trust the kernel
     result.resize(cpu_mapping.back() + 1);
+    if (!ptr)
+        return;
 
-    while (getline(&line, &len, f) != -1) {
-        // Skip any blanks at the start of the line
-        char *ptr = skip_to_non_blank(line);
-        if (strncmp(ptr, hdr, strlen(hdr)) != 0)
-            continue;
-
-        ptr = ptr + strlen(hdr);
-        for (int i = 0; *ptr != '\0'; ++i) {
-            char *endptr;
-            errno = 0;
-            uint64_t n = strtoull(ptr, &endptr, 10);
-            if (n == 0 && ptr == endptr)
-                break;
-            // static code analyzers: we trust the kernel
-            result[cpu_mapping[i]] = n;
-            ptr = endptr;
-        }
-        break;
+    for (int cpu : cpu_mapping) {
+        ptr = skip_to_non_blank(ptr);
+        if (*ptr < '0' || *ptr > '9')
+            break;              // end of the numeric columns
+
+        char *endptr;
+        result[cpu] = strtoull(ptr, &endptr, 10);
+        ptr = endptr;
+    }
+}
+
+// this function reads the interrupts file once and returns the per-CPU counts
+// in the MCE and thermal (TRM) rows
+InterruptMonitor::InterruptCounts InterruptMonitor::get_all_interrupt_counts()
+{
+    static_assert(InterruptMonitorWorks);
+    static ProcInterruptsFile f;
+
+    InterruptCounts result;
+    if (f.fd < 0)
+        return result;
+
+    std::string_view contents = f.read();
+
+    // read the header and create the CPU mapping
+    size_t header_len = contents.find('\n');
+    if (header_len != std::string_view::npos)
+        ++header_len;           // like getline(), include the newline
+    else
+        header_len = contents.size();
+    const std::vector<int> &cpu_mapping =
+            parse_header(const_cast<char *>(contents.data()), header_len);
+    if (cpu_mapping.size() == 0) {
+        // failed to parse the header!
+        close(f.fd);
+        f.fd = -1;
+        return result;
     }
 
-    // reset the file pointer for the next time we get called
-    fseek(f, 0, SEEK_SET);
+    parse_row(find_row(contents, f.row_offsets[MCE], "MCE:"), cpu_mapping, result.mce);
+    parse_row(find_row(contents, f.row_offsets[Thermal], "TRM:"), cpu_mapping, result.thermal);
     return result;
 }
 
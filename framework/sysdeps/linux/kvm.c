@@ -64,6 +64,9 @@ int kvm_fd = -1;
 
 #define DEFAULT_RAM_SIZE (2 * 1024 * 1024)
 
+/* vCPUs are only freed with their VM, so don't create too many in each */
+#define VCPUS_PER_VM    16
+
 #define IOCTL_OR_RET(...) do {          \
         int ret = ioctl(__VA_ARGS__);   \
         if (ret == -1) return -errno;   \
@@ -165,7 +168,7 @@ static int kvm_generic_reset_vcpu(kvm_ctx_t *ctx, struct kvm_regs *regs)
     return EXIT_SUCCESS;
 }
 
-static int kvm_generic_add_vcpu(kvm_ctx_t *ctx)
+static int kvm_generic_add_vcpu(kvm_ctx_t *ctx, int vcpu_id)
 {
     int cpu_fd = -1;
 
@@ -174,7 +177,7 @@ static int kvm_generic_add_vcpu(kvm_ctx_t *ctx)
         return -errno;
     }
 
-    cpu_fd = ioctl(ctx->vm_fd, KVM_CREATE_VCPU, 0);
+    cpu_fd = ioctl(ctx->vm_fd, KVM_CREATE_VCPU, vcpu_id);
     if (cpu_fd == -1) {
         return -errno;
     }
@@ -464,6 +467,31 @@ static int kvm_generic_setup_cpuid(kvm_ctx_t *ctx)
     return EXIT_SUCCESS;
 }
 
+/* Sets up the guest RAM, which is shared by all vCPUs we create in the VM */
+static int kvm_generic_setup_vm(kvm_ctx_t *ctx)
+{
+    switch (ctx->config->addr_mode) {
+        case KVM_ADDR_MODE_REAL_16BIT:
+            ctx->ram_sz = ctx->config->ram_size;
+            if (kvm_real16_setup_ram(ctx)) {
+                return EXIT_FAILURE;
+            }
+            return EXIT_SUCCESS;
+        case KVM_ADDR_MODE_PROTECTED_64BIT:
+            ctx->ram_sz = kvm_prot64_check_ram_size(ctx->config->ram_size);
+            ctx->ram = kvm_prot64_setup_ram(ctx);
+            if (!ctx->ram) {
+                return EXIT_FAILURE;
+            }
+            if (kvm_prot64_setup_payload(ctx) < 0)
+                return EXIT_FAILURE;
+            return EXIT_SUCCESS;
+        default:
+            log_warning("Unsupported vcpu mode in KVM test %d.\n", ctx->config->addr_mode);
+            return EXIT_FAILURE;
+    }
+}
+
 static int kvm_generic_setup_vcpu(kvm_ctx_t *ctx)
 {
     struct kvm_sregs sregs;
@@ -476,20 +504,11 @@ static int kvm_generic_setup_vcpu(kvm_ctx_t *ctx)
 
     switch (ctx->config->addr_mode) {
         case KVM_ADDR_MODE_REAL_16BIT:
-            ctx->ram_sz = ctx->config->ram_size;
-            if (kvm_real16_setup_ram(ctx)) {
-                return EXIT_FAILURE;
-            }
             ret = kvm_real16_setup_sregs(&sregs, ctx);
             if (ret < 0)
                 return EXIT_FAILURE;
             return EXIT_SUCCESS;
         case KVM_ADDR_MODE_PROTECTED_64BIT:
-            ctx->ram_sz = kvm_prot64_check_ram_size(ctx->config->ram_size);
-            ctx->ram = kvm_prot64_setup_ram(ctx);
-            if (!ctx->ram) {
-                return EXIT_FAILURE;
-            }
             kvm_prot64_setup_paging(&sregs, ctx);
 
             kvm_prot64_setup_segmentation(&sregs, ctx->ram);
@@ -502,10 +521,6 @@ static int kvm_generic_setup_vcpu(kvm_ctx_t *ctx)
                     return EXIT_FAILURE;
             }
 
-            ret = kvm_prot64_setup_payload(ctx);
-            if (ret < 0)
-                return EXIT_FAILURE;
-
             return EXIT_SUCCESS;
         default:
             log_warning("Unsupported vcpu mode in KVM test %d.\n", ctx->config->addr_mode);
@@ -737,38 +752,52 @@ int kvm_generic_run(struct test *test, int cpu)
     }
 
     int count = 0;
+    int vcpu_id = 0;
     bool retry = false;
     do {
         /* Every 16 loops reset the A bit for the memory */
         if (count && (count % 16 == 0)) {
                 madvise(ctx.ram, ctx.ram_sz, MADV_COLD);
         }
-        /* Recycle VM every 128-th time. There's an issue with KVM running and
-         * resetting RIP: on 129-th run it would not function properly. */
+        /* Recycle the vCPU every 128-th time. There's an issue with KVM
+         * running and resetting RIP: on 129-th run it would not function
+         * properly. A new vCPU in the same VM is enough and avoids setting
+         * up the guest RAM again; the VM itself is only recreated once it
+         * has VCPUS_PER_VM of them. */
         if (count % 127 == 0) {
             if (count) {
-                close(ctx.vm_fd);
                 close(ctx.cpu_fd);
                 munmap(ctx.runs, ctx.run_sz);
-                munmap(ctx.ram, ctx.ram_sz);
-                ctx.vm_fd = -1;
                 ctx.cpu_fd = -1;
                 ctx.runs = NULL;
-                ctx.ram = NULL;
+                if (++vcpu_id == VCPUS_PER_VM) {
+                    close(ctx.vm_fd);
+                    munmap(ctx.ram, ctx.ram_sz);
+                    ctx.vm_fd = -1;
+                    ctx.ram = NULL;
+                    vcpu_id = 0;
+                }
             }
 
-            ctx.vm_fd = kvm_generic_create_vm(kvm_fd);
             if (ctx.vm_fd < 0) {
-                if (errno == EBUSY) {
-                    log_skip(OSResourceIssueSkipCategory, "Cannot create VM: device busy");
-                    result = EXIT_SKIP;
+                ctx.vm_fd = kvm_generic_create_vm(kvm_fd);
+                if (ctx.vm_fd < 0) {
+                    if (errno == EBUSY) {
+                        log_skip(OSResourceIssueSkipCategory, "Cannot create VM: device busy");
+                        result = EXIT_SKIP;
+                        goto epilogue;
+                    }
+                    result = EXIT_FAILURE;
+                    goto epilogue;
+                }
+
+                result = kvm_generic_setup_vm(&ctx);
+                if (result != EXIT_SUCCESS) {
                     goto epilogue;
                 }
-                result = EXIT_FAILURE;
-                goto epilogue;
             }
 
-            ctx.cpu_fd = kvm_generic_add_vcpu(&ctx);
+            ctx.cpu_fd = kvm_generic_add_vcpu(&ctx, vcpu_id);
             if (ctx.cpu_fd < 0) {
                 result = EXIT_FAILURE;
                 goto epilogue;
@@ -10,6 +10,7 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <unistd.h>
 
 #ifndef __SANITIZE_ADDRESS__
@@ -50,6 +51,19 @@ static void *bzero_block(void *ptr, size_t len)
     return memset(ptr, 0, len);
 }
 
+// Large blocks are served by glibc straight from mmap(), so they are already
+// zeroed by the kernel and writing to them would only fault in every page
+// ahead of the caller. glibc marks those chunks with the IS_MMAPPED bit in
+// the size field that precedes the block (see malloc/malloc.c).
+static bool is_mmapped_chunk(void *ptr)
+{
+    static constexpr size_t IsMmapped = 0x2;
+    size_t size_field;
+    memcpy(&size_field, reinterpret_cast<const void *>(uintptr_t(ptr) - sizeof(size_t)),
+           sizeof(size_field));
+    return size_field & IsMmapped;
+}
+
 static __attribute__((noinline, noreturn)) void null_pointer_consumption(void *ptr, size_t size)
 {
     static const char msg[] = "Out of memory condition\n";
@@ -72,10 +86,41 @@ static inline void *check_null_pointer(void *ptr, size_t size, size_t count = 1)
 static inline void *checked_allocation(size_t size, void *block)
 {
     check_null_pointer(block, size);
+    if (is_mmapped_chunk(block))
+        return block;
     size = malloc_usable_size(block);
     return bzero_block(block, size);
 }
 
+// With --huge-pages, blocks of 2 MB or more are aligned to 2 MB and always
+// come from mmap(), and we ask for transparent huge pages for them before
+// anything touches the memory. Smaller blocks are not affected.
+static constexpr size_t HugePageSize = 2 * 1024 * 1024;
+static bool use_huge_pages = false;
+
+void malloc_enable_huge_pages()
+{
+    if (use_huge_pages)
+        return;
+    // a fixed threshold also disables glibc's dynamic adjustment of it
+    mallopt(M_MMAP_THRESHOLD, HugePageSize);
+    use_huge_pages = true;
+}
+
+static inline bool is_huge_allocation(size_t size)
+{
+    return __builtin_expect(use_huge_pages, false) && size >= HugePageSize;
+}
+
+static void *huge_allocation(size_t alignment, size_t size)
+{
+    void *block = check_null_pointer(__libc_memalign(std::max(alignment, HugePageSize), size), size);
+    if (!is_mmapped_chunk(block))
+        return bzero_block(block, malloc_usable_size(block));
+    madvise(block, size & ~(HugePageSize - 1), MADV_HUGEPAGE);
+    return block;
+}
+
 // different from all the rest
 int posix_memalign(void **newptr, size_t alignment, size_t size)
 {
@@ -92,11 +137,15 @@ void *pvalloc(size_t bytes)
 
 void *aligned_alloc(size_t alignment, size_t size)
 {
+    if (is_huge_allocation(size))
+        return huge_allocation(alignment, size);
     return checked_allocation(size, __libc_memalign(alignment, size));
 }
 
 void *memalign(size_t alignment, size_t size)
 {
+    if (is_huge_allocation(size))
+        return huge_allocation(alignment, size);
     return checked_allocation(size, __libc_memalign(alignment, size));
 }
 
@@ -107,6 +156,8 @@ void *valloc(size_t size)
 
 void *malloc(size_t size)
 {
+    if (is_huge_allocation(size))
+        return huge_allocation(alignof(max_align_t), size);
     return checked_allocation(size, __libc_malloc(size));
 }
 
@@ -8,6 +8,7 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <paths.h>
+#include <pthread.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -48,54 +49,109 @@ static void try_load_kmod()
     atomic_store_explicit(&tried, true, memory_order_relaxed);
 }
 
-bool read_msr(int cpu, uint32_t msr, uint64_t * value)
+static int open_msr_file(int cpu, int mode)
 {
-    int fd;
-    bool ret = false;
     char filename[sizeof "/dev/cpu/2147483647/msr" + 1];
+    sprintf(filename, "/dev/cpu/%i/msr", cpu);
+
+    int fd = open(filename, mode | O_CLOEXEC);
+    if (fd == -1 && errno == EACCES)
+        atomic_store_explicit(&msr_access_denied, true, memory_order_relaxed);
+    return fd;
+}
+
+// File descriptors for /dev/cpu/N/msr, indexed by CPU number and opened on
+// first use: one table for reading and one for writing, so we only ask for
+// write access if something actually writes. They are stored plus one, so
+// zero means not yet open.
+enum { MsrRead, MsrWrite, MsrModeCount };
+static atomic_int *msr_fds[MsrModeCount];
+static int msr_fds_count;
+static pthread_once_t msr_fds_once = PTHREAD_ONCE_INIT;
 
+static void msr_fds_init()
+{
+    long count = sysconf(_SC_NPROCESSORS_CONF);
+    if (count <= 0)
+        return;
+    atomic_int *fds = calloc(count * MsrModeCount, sizeof(*fds));
+    if (!fds)
+        return;
+    for (int i = 0; i < MsrModeCount; ++i)
+        msr_fds[i] = fds + i * count;
+    msr_fds_count = count;
+}
+
+// Returns the file descriptor for the CPU's MSR file opened for reading
+// (MsrRead) or writing (MsrWrite), or -1 on error. If *must_close is set on
+// return, the caller must close it after use.
+static int msr_fd(int cpu, int which, bool *must_close)
+{
+    int mode = which == MsrWrite ? O_WRONLY : O_RDONLY;
+    *must_close = false;
     if (atomic_load_explicit(&msr_access_denied, memory_order_relaxed)) {
         errno = EACCES;
-        return false;
+        return -1;
     }
     try_load_kmod();
 
-    sprintf(filename, "/dev/cpu/%i/msr", cpu);
-    fd = open(filename, O_RDONLY | O_CLOEXEC);
-    if (fd == -1) {
-        if (errno == EACCES)
-            atomic_store_explicit(&msr_access_denied, true, memory_order_relaxed);
-        return false;
+    pthread_once(&msr_fds_once, msr_fds_init);
+    if (cpu < 0 || cpu >= msr_fds_count) {
+        // not in the table, don't cache
+        *must_close = true;
+        return open_msr_file(cpu, mode);
+    }
+
+    atomic_int *slot = &msr_fds[which][cpu];
+    int fd = atomic_load_explicit(slot, memory_order_acquire) - 1;
+    if (fd >= 0)
+        return fd;
+
+    fd = open_msr_file(cpu, mode);
+    if (fd == -1)
+        return -1;
+
+    int expected = 0;
+    if (!atomic_compare_exchange_strong_explicit(slot, &expected, fd + 1,
+                                                 memory_order_acq_rel, memory_order_acquire)) {
+        // another thread opened it first
+        close(fd);
+        fd = expected - 1;
     }
-    if (pread(fd, value, sizeof(*value), msr) == sizeof(*value))
-        ret = true;
+    return fd;
+}
 
-    close(fd);
+bool read_msrs(int cpu, const uint32_t *msrs, uint64_t *values, int count)
+{
+    bool must_close;
+    int fd = msr_fd(cpu, MsrRead, &must_close);
+    if (fd == -1)
+        return false;
+
+    bool ret = true;
+    for (int i = 0; i < count && ret; ++i)
+        ret = pread(fd, &values[i], sizeof(values[i]), msrs[i]) == sizeof(values[i]);
+
+    if (must_close)
+        close(fd);
     return ret;
 }
 
-bool write_msr(int cpu, uint32_t msr, uint64_t value)
+bool read_msr(int cpu, uint32_t msr, uint64_t * value)
 {
-    int fd;
-    bool ret = false;
-    char filename[sizeof "/dev/cpu/2147483647/msr" + 1];
+    return read_msrs(cpu, &msr, value, 1);
+}
 
-    if (atomic_load_explicit(&msr_access_denied, memory_order_relaxed)) {
-        errno = EACCES;
+bool write_msr(int cpu, uint32_t msr, uint64_t value)
+{
+    bool must_close;
+    int fd = msr_fd(cpu, MsrWrite, &must_close);
+    if (fd == -1)
         return false;
-    }
-    try_load_kmod();
 
-    sprintf(filename, "/dev/cpu/%i/msr", cpu);
-    fd = open(filename, O_WRONLY | O_CLOEXEC);
-    if (fd == -1) {
-        if (errno == EACCES)
-            atomic_store_explicit(&msr_access_denied, true, memory_order_relaxed);
-        return false;
-    }
-    if (pwrite(fd, &value, sizeof(value), msr) == sizeof(value))
-        ret = true;
+    bool ret = pwrite(fd, &value, sizeof(value), msr) == sizeof(value);
 
-    close(fd);
+    if (must_close)
+        close(fd);
     return ret;
 }
@@ -0,0 +1,53 @@
+/*
+ * Copyright 2025 Intel Corporation.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "sandstone_p.h"
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <linux/mempolicy.h>
+
+#define NODE_MASK_LONGS     (1024 / (sizeof(unsigned long) * CHAR_BIT))
+
+static int node_for_thread(int thread)
+{
+    if (thread < 0 || thread >= num_cpus())
+        return -1;
+    return cpu_info[thread].numa_id;
+}
+
+void *per_thread_alloc(int thread, size_t size)
+{
+    if (size == 0)
+        return NULL;
+
+    void *ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED)
+        return NULL;
+
+    /* Nothing has been faulted in yet, so setting the policy now places
+     * every page on the thread's node no matter which thread touches it
+     * first (test_init runs on the main thread). We prefer the node instead
+     * of binding to it, so we fall back to others if it's out of memory. */
+    int node = node_for_thread(thread);
+    if (node >= 0 && node < NODE_MASK_LONGS * sizeof(unsigned long) * CHAR_BIT) {
+        const int bits_per_long = sizeof(unsigned long) * CHAR_BIT;
+        unsigned long nodemask[NODE_MASK_LONGS] = {};
+        nodemask[node / bits_per_long] = 1UL << (node % bits_per_long);
+
+        /* the kernel ignores the last bit of maxnode */
+        syscall(SYS_mbind, ptr, size, MPOL_PREFERRED, nodemask,
+                sizeof(nodemask) * CHAR_BIT + 1, 0);
+    }
+    return ptr;
+}
+
+void per_thread_free(void *ptr, size_t size)
+{
+    if (ptr)
+        munmap(ptr, size);
+}
@@ -0,0 +1,138 @@
+/*
+ * Copyright 2025 Intel Corporation.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef LINUX_PERF_COUNTERS_HPP
+#define LINUX_PERF_COUNTERS_HPP
+
+#include "sandstone_p.h"
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+
+/*
+ * Opens one perf_event group for the calling thread, with the cycle counter
+ * as the group leader, so all counters are enabled, disabled and read
+ * together. Counters the kernel or the hardware doesn't support are skipped
+ * and reported as PerfCounterSet::NotAvailable.
+ */
+class PerfCounterGroup
+{
+public:
+    PerfCounterGroup()
+    {
+        std::fill(std::begin(fds), std::end(fds), -1);
+    }
+    ~PerfCounterGroup()
+    {
+        close_all();
+    }
+    PerfCounterGroup(const PerfCounterGroup &) = delete;
+    PerfCounterGroup &operator=(const PerfCounterGroup &) = delete;
+
+    void start()
+    {
+        for (int i = 0; i < PerfCounterSet::CounterCount; ++i) {
+            auto counter = PerfCounterSet::Counter(i);
+            int leader = fds[PerfCounterSet::Cycles];
+            if (counter != PerfCounterSet::Cycles && leader < 0)
+                break;          // no leader, no group
+            fds[i] = open_counter(counter, leader);
+        }
+
+        int leader = fds[PerfCounterSet::Cycles];
+        if (leader < 0)
+            return;
+        ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+
+    void stop(PerfCounterSet *result)
+    {
+        result->init();
+        int leader = fds[PerfCounterSet::Cycles];
+        if (leader < 0)
+            return;
+        ioctl(leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+        // { u64 nr; u64 time_enabled; u64 time_running; u64 values[nr]; }
+        // with the values in the order the counters were added to the group
+        uint64_t buf[3 + PerfCounterSet::CounterCount];
+        ssize_t n = read(leader, buf, sizeof(buf));
+        if (n >= ssize_t(3 * sizeof(uint64_t)) && buf[2]) {
+            uint64_t nr = std::min<uint64_t>(buf[0], (n / sizeof(uint64_t)) - 3);
+            uint64_t enabled = buf[1];
+            uint64_t running = buf[2];
+
+            // if the kernel had to multiplex the PMU with other users, the
+            // group only counted for part of the time: extrapolate
+            double scale = 1.0;
+            if (running < enabled) {
+                scale = double(enabled) / running;
+                result->multiplexed = true;
+            }
+
+            const uint64_t *value = buf + 3;
+            for (int i = 0; i < PerfCounterSet::CounterCount && nr; ++i) {
+                if (fds[i] < 0)
+                    continue;
+                result->values[i] = uint64_t(*value++ * scale);
+                --nr;
+            }
+        }
+        close_all();
+    }
+
+private:
+    int fds[PerfCounterSet::CounterCount];
+
+    static int open_counter(PerfCounterSet::Counter counter, int group_fd)
+    {
+        struct perf_event_attr attr = {};
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                PERF_FORMAT_TOTAL_TIME_RUNNING;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.disabled = group_fd < 0;
+
+        switch (counter) {
+        case PerfCounterSet::Cycles:
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case PerfCounterSet::Instructions:
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case PerfCounterSet::BranchMisses:
+            attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+        case PerfCounterSet::L1DMisses:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_L1D |
+                    (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                    (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            break;
+        case PerfCounterSet::LLCMisses:
+            attr.config = PERF_COUNT_HW_CACHE_MISSES;
+            break;
+        case PerfCounterSet::CounterCount:
+            __builtin_unreachable();
+        }
+
+        return syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, PERF_FLAG_FD_CLOEXEC);
+    }
+
+    void close_all()
+    {
+        for (int &fd : fds) {
+            if (fd >= 0)
+                close(fd);
+            fd = -1;
+        }
+    }
+};
+
+#endif //LINUX_PERF_COUNTERS_HPP
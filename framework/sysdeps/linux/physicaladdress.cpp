@@ -5,6 +5,9 @@
 
 #include "sandstone_p.h"
 
+#include <algorithm>
+#include <mutex>
+
 #include <sys/types.h>
 #include <fcntl.h>
 #include <unistd.h>
@@ -40,42 +43,102 @@
 //           present  in  swap  (bit  62), then bits 4-0 give the swap
 //           type, and bits 54-5 encode the swap offset.
 
-uint64_t retrieve_physical_address(const volatile void *ptr)
+static int pagemap_fd()
 {
-    struct CloseFd {
+    struct Pagemap {
+        std::mutex mutex;
+        pid_t pid = 0;
         int fd = -1;
-        ~CloseFd() { if (fd >= 0) close(fd); }
+        ~Pagemap() { if (fd >= 0) close(fd); }
     };
+    static Pagemap pagemap;
+
+    // /proc/self is resolved when opening, so a child process must not use
+    // the descriptor it inherited from its parent
+    std::lock_guard lock(pagemap.mutex);
+    if (pid_t pid = getpid(); pid != pagemap.pid) {
+        if (pagemap.fd >= 0)
+            close(pagemap.fd);
+        pagemap.fd = open("/proc/self/pagemap", O_RDONLY | O_CLOEXEC);
+        pagemap.pid = pid;
+    }
+    return pagemap.fd;
+}
 
+static bool valid_user_address(uintptr_t v)
+{
     // On Linux, the first and the last pages are always unmapped. The last
     // page needs to be for ABI reasons, as any negative values between -1 and
     // -4095 are errno codes. The first page because of NULL pointer
     // dereferences (unless MMAP_PAGE_ZERO personality is in effect, but the
     // less you know about that, the better).
     // /proc/sys/vm/mmap_min_addr also applies to non-superuser processes.
+    return v >= PAGE_SIZE && v <= ~uintptr_t(PAGE_SIZE);
+}
+
+// returns the physical address of the page the descriptor refers to, or 0
+static uint64_t descriptor_to_page_address(uint64_t descriptor)
+{
+    // bit 63: page present in RAM?
+    if (int64_t(descriptor) >= 0)
+        return 0;
+
+    // is the PFN a valid number?
+    descriptor &= (UINT64_C(1) << 54) - 1;
+    return descriptor << PAGE_SHIFT;
+}
 
+uint64_t retrieve_physical_address(const volatile void *ptr)
+{
     uintptr_t v = uintptr_t(ptr);
-    if (v < PAGE_SIZE || v > ~uintptr_t(PAGE_SIZE))
+    if (!valid_user_address(v))
         return 0;
 
-    static const CloseFd pagemap = { open("/proc/self/pagemap", O_RDONLY) };
-    if (pagemap.fd == -1)
+    int fd = pagemap_fd();
+    if (fd == -1)
         return 0;
 
     uint64_t descriptor;
     off_t pagemapoffset = v / PAGE_SIZE * sizeof(uint64_t);
-    int n = pread(pagemap.fd, &descriptor, sizeof(descriptor), pagemapoffset);
+    int n = pread(fd, &descriptor, sizeof(descriptor), pagemapoffset);
     if (n < 0)
         return 0;
 
-    // bit 63: page present in RAM?
-    if (int64_t(descriptor) >= 0)
+    uint64_t page = descriptor_to_page_address(descriptor);
+    if (!page)
         return 0;
 
-    // is the PFN a valid number?
-    descriptor &= (UINT64_C(1) << 54) - 1;
-    if (!descriptor)
+    return page + (v & (PAGE_SIZE - 1));
+}
+
+size_t retrieve_physical_address_range(const volatile void *ptr, size_t len, uint64_t *addresses,
+                                       size_t count)
+{
+    uintptr_t v = uintptr_t(ptr);
+    if (len == 0 || !valid_user_address(v) || !valid_user_address(v + len - 1) || v + len - 1 < v)
+        return 0;
+
+    size_t first_page = v / PAGE_SIZE;
+    size_t pages = (v + len - 1) / PAGE_SIZE - first_page + 1;
+    count = std::min(count, pages);
+    if (count == 0)
+        return pages;
+
+    int fd = pagemap_fd();
+    if (fd == -1)
+        return 0;
+
+    // read all the descriptors at once, directly into the caller's array
+    ssize_t n = pread(fd, addresses, count * sizeof(uint64_t), first_page * sizeof(uint64_t));
+    if (n < 0)
         return 0;
+    size_t read_count = size_t(n) / sizeof(uint64_t);
 
-    return (descriptor << PAGE_SHIFT) + (v & (PAGE_SIZE - 1));
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t page = i < read_count ? descriptor_to_page_address(addresses[i]) : 0;
+        if (page && i == 0)
+            page += v & (PAGE_SIZE - 1);
+        addresses[i] = page;
+    }
+    return pages;
 }
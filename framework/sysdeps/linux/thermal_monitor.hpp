@@ -6,8 +6,13 @@
 #ifndef SANDSTONE_LINUX_THERMAL_MONITOR_HPP
 #define SANDSTONE_LINUX_THERMAL_MONITOR_HPP
 
+#include <fcntl.h>
 #include <glob.h>
+#include <unistd.h>
+
+#include <charconv>
 #include <fstream>
+#include <string_view>
 
 
 #define DEFAULT_SYS_THERMAL_PATH "/sys/devices/virtual/thermal/"
@@ -15,12 +20,24 @@
 
 class ThermalMonitor {
 
-    std::vector<std::string> socket_temperature_files;
+    // the sensor files are kept open and re-read with pread(); -1 means
+    // the index isn't a socket
+    std::vector<int> socket_temperature_fds;
 public:
     explicit ThermalMonitor(const std::string &thermal_path_sys_root = DEFAULT_SYS_THERMAL_PATH) {
         discover_socket_temperature_files(thermal_path_sys_root);
     }
 
+    ~ThermalMonitor() {
+        for (int fd : socket_temperature_fds) {
+            if (fd >= 0)
+                close(fd);
+        }
+    }
+
+    ThermalMonitor(const ThermalMonitor &) = delete;
+    ThermalMonitor &operator=(const ThermalMonitor &) = delete;
+
 
     // Simple static singleton pattern because we only ever want one of these
     // which we use in the static method below which is the primary API
@@ -47,9 +64,10 @@ public:
 
     void add_socket_temperature_file(const std::string &directory_path) {
         int socket_num = get_last_int_from(directory_path);
-        socket_temperature_files.resize( std::max(socket_num + 1, (int) socket_temperature_files.size()) );
+        socket_temperature_fds.resize( std::max(socket_num + 1, (int) socket_temperature_fds.size()), -1 );
 
-        socket_temperature_files[socket_num] = directory_path + "/temp";
+        std::string file_path = directory_path + "/temp";
+        socket_temperature_fds[socket_num] = open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
     }
 
 
@@ -68,29 +86,43 @@ public:
     //
     std::vector<int> get_socket_temperatures() {
         std::vector<int> temps;
-        for (auto &file_path : socket_temperature_files) {
-            if (file_path.empty())
+        temps.reserve(socket_temperature_fds.size());
+        for (int fd : socket_temperature_fds) {
+            if (fd < 0)
                 temps.push_back(INVALID_TEMPERATURE);
             else
-                temps.push_back(read_value_from_file(file_path));
+                temps.push_back(read_value_from_fd(fd));
         }
         return temps;
     }
 
 
+    static int read_value_from_fd(int fd) {
+        char buf[32];
+        ssize_t n = pread(fd, buf, sizeof(buf), 0);
+        if (n <= 0)
+            return INVALID_TEMPERATURE;
+
+        std::string_view line(buf, n);
+        return get_last_int_from(line.substr(0, line.find('\n')));
+    }
+
+
     static int read_value_from_file(const std::string &file) {
         return get_last_int_from(first_line_of(file));
     }
 
 
-    static int get_last_int_from(const std::string &line) {
+    static int get_last_int_from(std::string_view line) {
         auto last_idx = line.find_last_not_of("0123456789");
-        std::string number_string = line.substr(last_idx + 1);
+        std::string_view number_string = line.substr(last_idx + 1);
 
+        long value = 0;
         if (number_string.empty()) {
             return INVALID_TEMPERATURE;
         } else {
-            return (int) strtol(number_string.c_str(), nullptr, 10);
+            std::from_chars(number_string.data(), number_string.data() + number_string.size(), value);
+            return (int) value;
         }
     }
 
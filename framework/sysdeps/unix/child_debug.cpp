@@ -1108,10 +1108,12 @@ static int find_slice_by_pid(pid_t child, std::span<const pid_t> children)
     return -1;
 }
 
-void debug_crashed_child(std::span<const pid_t> children)
+// Returns the slices that sent a crash context and will exit on their own.
+std::vector<int> debug_crashed_child(std::span<const pid_t> children)
 {
+    std::vector<int> exiting;
     if (!SandstoneConfig::ChildDebugCrashes || sApp->shmem->server_debug_socket == -1)
-        return;
+        return exiting;
 
     // receive the context
     alignas(16) uint8_t xsave_area[xsave_size];     // Variable Length Array, a.k.a. alloca
@@ -1145,7 +1147,12 @@ void debug_crashed_child(std::span<const pid_t> children)
             thread_state.store(thread_debugged, std::memory_order_relaxed);
             futex_wake_all(&thread_state);
         }
+
+        // don't hurry a child that's writing a core dump
+        if ((on_crash_action & coredump_on_crash) == 0)
+            exiting.push_back(slice);
     }
+    return exiting;
 }
 
 void debug_hung_child(pid_t child, std::span<const pid_t> children)
@@ -293,12 +293,14 @@ static void attach_gdb(HANDLE child)
     close(saved_stdout);
 }
 
-void debug_crashed_child(std::span<const pid_t> children)
+std::vector<int> debug_crashed_child(std::span<const pid_t> children)
 {
+    // the context doesn't identify the child, so we can't report which ones
+    // are exiting
     if (!SandstoneConfig::ChildDebugCrashes)
-        return;
+        return {};
     if (hSlot == INVALID_HANDLE_VALUE)
-        return;
+        return {};
     (void) children;
 
     ResetEvent(HANDLE(sApp->shmem->debug_event));
@@ -308,7 +310,7 @@ void debug_crashed_child(std::span<const pid_t> children)
     AutoClosingFile log;
     while (GetMailslotInfo(hSlot, nullptr, &dwNextMessage, nullptr, nullptr)) {
         if (dwNextMessage == MAILSLOT_NO_MESSAGE)
-            return;
+            return {};
 
         if (buf.size() < dwNextMessage)
             buf.resize(dwNextMessage);
@@ -337,6 +339,7 @@ void debug_crashed_child(std::span<const pid_t> children)
     CloseHandle(hSlot);
     CloseHandle(HANDLE(sApp->shmem->debug_event));
     sApp->shmem->debug_event = 0;
+    return {};
 }
 
 void debug_hung_child(pid_t child, std::span<const pid_t> children)
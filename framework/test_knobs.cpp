@@ -7,8 +7,8 @@
 
 #include "sandstone.h"
 
-#include <map>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <boost/algorithm/string.hpp>
 
@@ -36,19 +36,12 @@ public:
 
 class TestKnobSingleton {
 private:
-    struct Entry {
-        std::string key;
-        std::string value;
-    };
-    std::vector<Entry> test_knobs;
-    Entry *find_key(std::string_view key)
+    // allows lookups by std::string_view without creating a std::string
+    struct KeyHash : std::hash<std::string_view>
     {
-        for (auto it = test_knobs.begin(); it != test_knobs.end(); ++it) {
-            if (it->key == key)
-                return &*it;
-        }
-        return nullptr;
-    }
+        using is_transparent = void;
+    };
+    std::unordered_map<std::string, std::string, KeyHash, std::equal_to<>> test_knobs;
 
     static TestKnobSingleton & instance()
     {
@@ -59,17 +52,14 @@ private:
 public:
     static void set_knob(std::string key, std::string value)
     {
-        Entry *e = instance().find_key(key);
-        if (e)
-            e->value = std::move(value);
-        else
-            instance().test_knobs.emplace_back(Entry{std::move(key), std::move(value)});
+        instance().test_knobs.insert_or_assign(std::move(key), std::move(value));
     }
 
     static std::string_view get_knob(std::string_view key)
     {
-        const Entry *e = instance().find_key(key);
-        return e ? e->value : std::string_view();
+        const auto &knobs = instance().test_knobs;
+        auto it = knobs.find(key);
+        return it != knobs.end() ? std::string_view(it->second) : std::string_view();
     }
 
     static void clear()
@@ -86,8 +76,8 @@ void clear_test_knobs(){
 
 // external interface methods
 
-template <typename Int> static
-Int knob_value_integer(const struct test *test, const char *k, Int value_if_not_present)
+template <typename Handle, typename Int> static
+Handle knob_value_integer(const struct test *test, const char *k, Int value_if_not_present)
 {
     TestKeyWrapper key(test, k);
     std::string_view s = TestKnobSingleton::get_knob(key);
@@ -98,15 +88,15 @@ Int knob_value_integer(const struct test *test, const char *k, Int value_if_not_
         unsigned long long value = strtoull(s.data(), &endptr, 0);
         if (endptr == s.end()) {
             logging_mark_knob_used(key, Int(value), KnobOrigin::Options);
-            return Int(value);
+            return { Int(value), true };
         };
     }
     logging_mark_knob_used(key, value_if_not_present, KnobOrigin::Defaulted);
-    return value_if_not_present;
+    return { value_if_not_present, false };
 }
 
 static
-double knob_value_double(const struct test *test, const char *k, double value_if_not_present)
+struct test_knob_double knob_value_double(const struct test *test, const char *k, double value_if_not_present)
 {
     TestKeyWrapper key(test, k);
     std::string_view s = TestKnobSingleton::get_knob(key);
@@ -118,43 +108,67 @@ double knob_value_double(const struct test *test, const char *k, double value_if
 
         if (endptr == s.end()) {
             logging_mark_knob_used(key, value, KnobOrigin::Options);
-            return value;
+            return { value, true };
         };
     }
     logging_mark_knob_used(key, value_if_not_present, KnobOrigin::Defaulted);
-    return value_if_not_present;
+    return { value_if_not_present, false };
 }
 
 #if !SANDSTONE_RESTRICTED_CMDLINE
-const char *get_testspecific_knob_value_string(const struct test *test, const char *key,
-                                               const char *value_if_not_present)
+struct test_knob_string resolve_testspecific_knob_string(const struct test *test, const char *key,
+                                                         const char *value_if_not_present)
 {
     TestKeyWrapper k(test, key);
     std::string_view s = TestKnobSingleton::get_knob(k);
     if (s.data()) {
         logging_mark_knob_used(k, s, KnobOrigin::Options);
-        return s.data();
+        return { s.data(), true };
     }
     std::string_view v;
     if (value_if_not_present)
         v = value_if_not_present;
     logging_mark_knob_used(k, v, KnobOrigin::Defaulted);
-    return value_if_not_present;
+    return { value_if_not_present, false };
+}
+
+struct test_knob_uint resolve_testspecific_knob_uint(const struct test *test, const char *key,
+                                                     uint64_t value_if_not_present)
+{
+    return knob_value_integer<struct test_knob_uint>(test, key, value_if_not_present);
+}
+
+struct test_knob_int resolve_testspecific_knob_int(const struct test *test, const char *key,
+                                                   int64_t value_if_not_present)
+{
+    return knob_value_integer<struct test_knob_int>(test, key, value_if_not_present);
+}
+
+struct test_knob_double resolve_testspecific_knob_double(const struct test *test, const char *key,
+                                                         double value_if_not_present)
+{
+    return knob_value_double(test, key, value_if_not_present);
+}
+
+const char *get_testspecific_knob_value_string(const struct test *test, const char *key,
+                                               const char *value_if_not_present)
+{
+    return resolve_testspecific_knob_string(test, key, value_if_not_present).value;
 }
 
 uint64_t get_testspecific_knob_value_uint(const struct test *test, const char *key, uint64_t value_if_not_present)
 {
-    return knob_value_integer(test, key, value_if_not_present);
+    return resolve_testspecific_knob_uint(test, key, value_if_not_present).value;
 }
 
 int64_t get_testspecific_knob_value_int(const struct test *test, const char *key, int64_t value_if_not_present)
 {
-    return knob_value_integer(test, key, value_if_not_present);
+    return resolve_testspecific_knob_int(test, key, value_if_not_present).value;
 }
 
 double get_testspecific_knob_value_double(const struct test *test, const char *key, double value_if_not_present)
 {
-    return knob_value_double(test, key, value_if_not_present);
+    return resolve_testspecific_knob_double(test, key, value_if_not_present).value;
 }
 
 bool set_knob_from_key_value_string(const char *key_value_pair) {
@@ -18,15 +18,49 @@ extern "C" {
 #endif
 
 #include "sandstone_config.h"
+
+struct test;
+
+/*
+ * Typed handles for test knobs: resolve them once in the test's init function
+ * (which is also where the knob is logged) and keep them in the test's data.
+ * Reading the value later, from any thread, is just a field access. The
+ * "present" member tells whether the value came from the command-line.
+ */
+struct test_knob_uint { uint64_t value; bool present; };
+struct test_knob_int { int64_t value; bool present; };
+struct test_knob_double { double value; bool present; };
+struct test_knob_string { const char *value; bool present; };
+
 #if SANDSTONE_RESTRICTED_CMDLINE
 #  define get_testspecific_knob_value_uint(test, key, value_if_not_present)    (uint64_t)(value_if_not_present)
 #  define get_testspecific_knob_value_int(test, key, value_if_not_present)    (int64_t)(value_if_not_present)
 #  define get_testspecific_knob_value_string(test, key, value_if_not_present) (const char*)(value_if_not_present)
 #  define get_testspecific_knob_value_double(test, key, value_if_not_present) (double)(value_if_not_present)
 #  define set_knob_from_key_value_string(key_value_pair)     ((bool) true)
+
+static inline struct test_knob_uint
+resolve_testspecific_knob_uint(const struct test *test, const char *key, uint64_t value_if_not_present)
+{ (void) test; (void) key; struct test_knob_uint r = { value_if_not_present, false }; return r; }
+static inline struct test_knob_int
+resolve_testspecific_knob_int(const struct test *test, const char *key, int64_t value_if_not_present)
+{ (void) test; (void) key; struct test_knob_int r = { value_if_not_present, false }; return r; }
+static inline struct test_knob_double
+resolve_testspecific_knob_double(const struct test *test, const char *key, double value_if_not_present)
+{ (void) test; (void) key; struct test_knob_double r = { value_if_not_present, false }; return r; }
+static inline struct test_knob_string
+resolve_testspecific_knob_string(const struct test *test, const char *key, const char *value_if_not_present)
+{ (void) test; (void) key; struct test_knob_string r = { value_if_not_present, false }; return r; }
 #else
 
-struct test;
+struct test_knob_uint resolve_testspecific_knob_uint(const struct test *test, const char *key,
+                                                     uint64_t value_if_not_present);
+struct test_knob_int resolve_testspecific_knob_int(const struct test *test, const char *key,
+                                                   int64_t value_if_not_present);
+struct test_knob_double resolve_testspecific_knob_double(const struct test *test, const char *key,
+                                                         double value_if_not_present);
+struct test_knob_string resolve_testspecific_knob_string(const struct test *test, const char *key,
+                                                         const char *value_if_not_present);
 
 uint64_t get_testspecific_knob_value_uint(const struct test *test, const char *key,
                                           uint64_t value_if_not_present);
@@ -50,6 +84,15 @@ static inline double  get_test_knob_value_double(const char *key, double value_i
 static inline const char *get_test_knob_value_string(const char *key, const char *value_if_not_present)
 { return get_testspecific_knob_value_string(NULL, key, value_if_not_present); }
 
+static inline struct test_knob_uint resolve_test_knob_uint(const char *key, uint64_t value_if_not_present)
+{ return resolve_testspecific_knob_uint(NULL, key, value_if_not_present); }
+static inline struct test_knob_int resolve_test_knob_int(const char *key, int64_t value_if_not_present)
+{ return resolve_testspecific_knob_int(NULL, key, value_if_not_present); }
+static inline struct test_knob_double resolve_test_knob_double(const char *key, double value_if_not_present)
+{ return resolve_testspecific_knob_double(NULL, key, value_if_not_present); }
+static inline struct test_knob_string resolve_test_knob_string(const char *key, const char *value_if_not_present)
+{ return resolve_testspecific_knob_string(NULL, key, value_if_not_present); }
+
 
 #ifdef __cplusplus
 } // extern "C"
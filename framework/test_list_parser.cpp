@@ -0,0 +1,69 @@
+/*
+ * Copyright 2025 Intel Corporation.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "test_list_parser.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <strings.h>
+
+#include <vector>
+
+static inline bool is_ignored(char c) {
+    switch (c) {
+        case ' ':
+        case '\t':
+            return true;
+        default:
+            return false;
+    }
+}
+
+static inline bool is_terminator(char c) {
+    switch (c) {
+        case '#':
+        case ':':
+            return true;
+        default:
+            return false;
+    }
+}
+
+TestListLine::Type parse_test_list_line(std::string_view line, TestListLine &result)
+{
+    std::vector<std::string> tokens;
+    auto it = line.begin();
+    while (it != line.end() && is_ignored(*it)) ++it;
+    if (it == line.end() || *it == '#') return TestListLine::Empty;
+    for (; ; ++it) {
+        /* skip blanks after the previous terminator */
+        while (it != line.end() && is_ignored(*it)) ++it;
+        auto cit = it;
+        /* scroll while it's valid token contents: till end of line, a
+         * terminator, or a space. */
+        while (cit != line.end() && !is_terminator(*cit) && !is_ignored(*cit)) ++cit;
+        auto tend = cit;
+        while (cit != line.end() && is_ignored(*cit)) ++cit;
+        if (cit != line.end() && !is_terminator(*cit)) return TestListLine::SyntaxError;
+        tokens.emplace_back(it, tend);
+        if (cit == line.end() || *cit == '#') break;
+        it = cit;
+    }
+    if (!tokens.size()) __builtin_unreachable();
+    if (tokens.size() > 3) return TestListLine::SyntaxError;
+    result.test_id = std::move(tokens[0]);
+    if (tokens.size() >= 2) {
+        if (tokens[1].size() && strcasecmp(tokens[1].c_str(), "default") != 0)
+            result.duration = string_to_millisecs(tokens[1]);
+    }
+    if (tokens.size() == 3 && tokens[2].size()) {
+        /* the weight: a non-negative number */
+        char *end;
+        result.weight = strtod(tokens[2].c_str(), &end);
+        if (*end != '\0' || !(result.weight >= 0) || result.weight == HUGE_VAL)
+            return TestListLine::SyntaxError;
+    }
+    return TestListLine::Valid;
+}
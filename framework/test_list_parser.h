@@ -0,0 +1,36 @@
+/*
+ * Copyright 2025 Intel Corporation.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef SANDSTONE_TEST_LIST_PARSER_H
+#define SANDSTONE_TEST_LIST_PARSER_H
+
+#include "sandstone_chrono.h"
+
+#include <string>
+#include <string_view>
+
+/*
+ * One line of a --test-list-file, split into its fields:
+ *
+ *      <test-id> [: <duration> [: <weight>]] [# comment]
+ *
+ * The test id is not looked up here.
+ */
+struct TestListLine
+{
+    enum Type {
+        Valid,
+        Empty,
+        SyntaxError,
+    };
+
+    std::string test_id;
+    ShortDuration duration = ShortDuration::zero();     // zero: test's default
+    double weight = 1.0;
+};
+
+TestListLine::Type parse_test_list_line(std::string_view line, TestListLine &result);
+
+#endif // SANDSTONE_TEST_LIST_PARSER_H
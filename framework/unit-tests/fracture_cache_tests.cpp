@@ -0,0 +1,102 @@
+/*
+ * Copyright 2025 Intel Corporation.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "gtest/gtest.h"
+
+#include "fracture_cache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <string>
+
+class FractureCacheFixture : public ::testing::Test {
+protected:
+    std::string path;
+
+    void SetUp() override
+    {
+        char name[] = "/tmp/fracture_cache_XXXXXX";
+        int fd = mkstemp(name);
+        ASSERT_NE(fd, -1);
+        close(fd);
+        path = name;
+    }
+
+    void TearDown() override
+    {
+        unlink(path.c_str());
+    }
+
+    void write_file(const char *contents)
+    {
+        std::ofstream(path) << contents;
+    }
+};
+
+TEST_F(FractureCacheFixture, MissingFile_IsEmpty)
+{
+    FractureCache cache(path + ".does-not-exist", "06-8f-08");
+    cache.load();
+    EXPECT_EQ(cache.find("zlib_aaa"), nullptr);
+}
+
+TEST_F(FractureCacheFixture, SaveAndLoad_RoundTrips)
+{
+    {
+        FractureCache cache(path, "06-8f-08");
+        cache.update("zlib_aaa", { .loop_count = 640, .ns_per_loop = 15234 });
+        cache.update("eigen_gemm_double14", { .loop_count = 80, .ns_per_loop = 250000 });
+        ASSERT_TRUE(cache.save());
+    }
+
+    FractureCache cache(path, "06-8f-08");
+    cache.load();
+    const FractureCache::Entry *e = cache.find("zlib_aaa");
+    ASSERT_NE(e, nullptr);
+    EXPECT_EQ(e->loop_count, 640);
+    EXPECT_EQ(e->ns_per_loop, 15234U);
+    e = cache.find("eigen_gemm_double14");
+    ASSERT_NE(e, nullptr);
+    EXPECT_EQ(e->loop_count, 80);
+    EXPECT_EQ(cache.find("zstd1"), nullptr);
+}
+
+TEST_F(FractureCacheFixture, OtherCpuModels_AreNotUsedButAreKept)
+{
+    write_file("06-55-04 zlib_aaa 160 40000\n");
+    {
+        FractureCache cache(path, "06-8f-08");
+        cache.load();
+        EXPECT_EQ(cache.find("zlib_aaa"), nullptr);
+        cache.update("zlib_aaa", { .loop_count = 640, .ns_per_loop = 15234 });
+        ASSERT_TRUE(cache.save());
+    }
+
+    FractureCache cache(path, "06-55-04");
+    cache.load();
+    const FractureCache::Entry *e = cache.find("zlib_aaa");
+    ASSERT_NE(e, nullptr);
+    EXPECT_EQ(e->loop_count, 160);
+}
+
+TEST_F(FractureCacheFixture, MalformedLines_AreIgnored)
+{
+    write_file("# comment\n"
+               "06-8f-08 zlib_aaa\n"
+               "06-8f-08 zstd1 abc 12\n"
+               "06-8f-08 zlib_a -5 12\n"
+               "\n"
+               "06-8f-08 zlib_aa 320 1000\n");
+    FractureCache cache(path, "06-8f-08");
+    cache.load();
+    EXPECT_EQ(cache.find("zlib_aaa"), nullptr);
+    EXPECT_EQ(cache.find("zstd1"), nullptr);
+    EXPECT_EQ(cache.find("zlib_a"), nullptr);
+    ASSERT_NE(cache.find("zlib_aa"), nullptr);
+    EXPECT_EQ(cache.find("zlib_aa")->loop_count, 320);
+}
@@ -8,6 +8,7 @@
 
 #include <string.h>
 #include <iomanip>
+#include <vector>
 
 static constexpr bool UseF16C = false
 #ifdef __F16C__
@@ -226,3 +227,52 @@ TEST(BFloat16, NaNConversions)
 
     EXPECT_EQ(FloatWrapper{frombf16_emulated(BFloat16::signaling_NaN())}, quieted_snan);
 }
+
+// compares the array conversions against the emulated ones for every 16-bit input
+TEST(Float16, ArrayConversionsAllInputs)
+{
+    constexpr size_t Count = 65536;
+    std::vector<Float16> halves(Count);
+    std::vector<float> floats(Count);
+    for (size_t i = 0; i < Count; ++i) {
+        halves[i].payload = i;
+        // spread the bits over the whole float, so we get NaNs, infinities,
+        // denormals and inexact conversions
+        uint32_t u = i << 16 | i;
+        memcpy(&floats[i], &u, sizeof(u));
+    }
+
+    std::vector<float> from_halves(Count);
+    fromfp16_array(from_halves.data(), halves.data(), Count);
+    for (size_t i = 0; i < Count; ++i)
+        ASSERT_EQ(FloatWrapper{from_halves[i]}, FloatWrapper{fromfp16_emulated(halves[i])})
+                << "Source: 0x" << std::hex << i;
+
+    std::vector<Float16> to_halves(Count);
+    tofp16_array(to_halves.data(), floats.data(), Count);
+    for (size_t i = 0; i < Count; ++i)
+        ASSERT_EQ(to_halves[i].payload, tofp16_emulated(floats[i]).payload)
+                << "Source: " << FloatWrapper{floats[i]};
+
+    // and converting back what we got from the halves
+    tofp16_array(to_halves.data(), from_halves.data(), Count);
+    for (size_t i = 0; i < Count; ++i)
+        ASSERT_EQ(to_halves[i].payload, tofp16_emulated(from_halves[i]).payload)
+                << "Source: " << FloatWrapper{from_halves[i]};
+}
+
+TEST(BFloat16, ArrayConversionsAllInputs)
+{
+    constexpr size_t Count = 65536;
+    std::vector<float> floats(Count);
+    for (size_t i = 0; i < Count; ++i) {
+        uint32_t u = i << 16 | i;
+        memcpy(&floats[i], &u, sizeof(u));
+    }
+
+    std::vector<BFloat16> to_bf16(Count);
+    tobf16_array(to_bf16.data(), floats.data(), Count);
+    for (size_t i = 0; i < Count; ++i)
+        ASSERT_EQ(to_bf16[i].payload, tobf16_emulated(floats[i]).payload)
+                << "Source: " << FloatWrapper{floats[i]};
+}
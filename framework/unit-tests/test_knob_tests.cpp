@@ -137,6 +137,42 @@ TEST_F(KnobTestSuite, read_knob_from_cmdline_argument_string){
     EXPECT_EQ(get_test_knob_value_uint("FOO", 0), 10);
 };
 
+TEST_F(KnobTestSuite, setting_knob_again_replaces_value){
+    set_knob_from_key_value_string("FOO=10");
+    set_knob_from_key_value_string("FOO=20");
+    EXPECT_EQ(get_test_knob_value_uint("FOO", 0), 20);
+};
+
+TEST_F(KnobTestSuite, resolved_handles_carry_value_and_origin) {
+    struct test t = { .id = "TestName" };
+    set_knob_from_key_value_string("TestName.Ten=10");
+    set_knob_from_key_value_string("NegOne=-1");
+    set_knob_from_key_value_string("OnePt5=1.5");
+    set_knob_from_key_value_string("Key1=Key1_Value");
+
+    struct test_knob_uint ten = resolve_testspecific_knob_uint(&t, "Ten", 0);
+    EXPECT_EQ(ten.value, 10);
+    EXPECT_TRUE(ten.present);
+    assertKnobWasUsed("TestName.Ten", UINT64_C(10), KnobOrigin::Options);
+
+    struct test_knob_int neg_one = resolve_test_knob_int("NegOne", 0);
+    EXPECT_EQ(neg_one.value, -1);
+    EXPECT_TRUE(neg_one.present);
+
+    struct test_knob_double one_pt_5 = resolve_test_knob_double("OnePt5", 0);
+    EXPECT_EQ(one_pt_5.value, 1.5);
+    EXPECT_TRUE(one_pt_5.present);
+
+    struct test_knob_string key1 = resolve_test_knob_string("Key1", "Default");
+    EXPECT_STREQ(key1.value, "Key1_Value");
+    EXPECT_TRUE(key1.present);
+
+    struct test_knob_uint missing = resolve_test_knob_uint("NonExistingKey", 20);
+    EXPECT_EQ(missing.value, 20);
+    EXPECT_FALSE(missing.present);
+    assertKnobWasUsed("NonExistingKey", UINT64_C(20), KnobOrigin::Defaulted);
+}
+
 TEST_F(KnobTestSuite, malformed_cmdline_argument_with_no_value_returns_failure){
     EXPECT_EQ(set_knob_from_key_value_string("FOO"), false);
 };
@@ -0,0 +1,86 @@
+/*
+ * Copyright 2025 Intel Corporation.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "gtest/gtest.h"
+
+#include "test_list_parser.h"
+
+using namespace std::chrono_literals;
+
+TEST(TestListParser, EmptyAndComments)
+{
+    TestListLine line;
+    EXPECT_EQ(parse_test_list_line("", line), TestListLine::Empty);
+    EXPECT_EQ(parse_test_list_line("   \t", line), TestListLine::Empty);
+    EXPECT_EQ(parse_test_list_line("# a comment", line), TestListLine::Empty);
+    EXPECT_EQ(parse_test_list_line("  # indented comment", line), TestListLine::Empty);
+}
+
+TEST(TestListParser, TestIdOnly)
+{
+    TestListLine line;
+    ASSERT_EQ(parse_test_list_line("zlib_aaa", line), TestListLine::Valid);
+    EXPECT_EQ(line.test_id, "zlib_aaa");
+    EXPECT_EQ(line.duration, 0ms);
+    EXPECT_EQ(line.weight, 1.0);
+
+    line = {};
+    ASSERT_EQ(parse_test_list_line("  zlib_aaa  # trailing comment", line), TestListLine::Valid);
+    EXPECT_EQ(line.test_id, "zlib_aaa");
+}
+
+TEST(TestListParser, Duration)
+{
+    TestListLine line;
+    ASSERT_EQ(parse_test_list_line("zlib_aaa:250", line), TestListLine::Valid);
+    EXPECT_EQ(line.duration, 250ms);
+
+    line = {};
+    ASSERT_EQ(parse_test_list_line("zlib_aaa: default", line), TestListLine::Valid);
+    EXPECT_EQ(line.duration, 0ms);
+
+    EXPECT_EQ(parse_test_list_line("zlib_aaa 250", line), TestListLine::SyntaxError);
+}
+
+TEST(TestListParser, Weight)
+{
+    TestListLine line;
+    ASSERT_EQ(parse_test_list_line("zlib_aaa:250:2.5", line), TestListLine::Valid);
+    EXPECT_EQ(line.test_id, "zlib_aaa");
+    EXPECT_EQ(line.duration, 250ms);
+    EXPECT_EQ(line.weight, 2.5);
+
+    line = {};
+    ASSERT_EQ(parse_test_list_line("zlib_aaa : default : 3 # comment", line), TestListLine::Valid);
+    EXPECT_EQ(line.duration, 0ms);
+    EXPECT_EQ(line.weight, 3.0);
+
+    // zero is valid: it disables the test in the weighted schedule
+    line = {};
+    ASSERT_EQ(parse_test_list_line("zlib_aaa::0", line), TestListLine::Valid);
+    EXPECT_EQ(line.weight, 0.0);
+}
+
+TEST(TestListParser, MissingWeight)
+{
+    TestListLine line;
+    ASSERT_EQ(parse_test_list_line("zlib_aaa:250", line), TestListLine::Valid);
+    EXPECT_EQ(line.weight, 1.0);
+
+    line = {};
+    ASSERT_EQ(parse_test_list_line("zlib_aaa:250:", line), TestListLine::Valid);
+    EXPECT_EQ(line.weight, 1.0);
+}
+
+TEST(TestListParser, MalformedWeight)
+{
+    TestListLine line;
+    EXPECT_EQ(parse_test_list_line("zlib_aaa:250:-1", line), TestListLine::SyntaxError);
+    EXPECT_EQ(parse_test_list_line("zlib_aaa:250:heavy", line), TestListLine::SyntaxError);
+    EXPECT_EQ(parse_test_list_line("zlib_aaa:250:2x", line), TestListLine::SyntaxError);
+    EXPECT_EQ(parse_test_list_line("zlib_aaa:250:nan", line), TestListLine::SyntaxError);
+    EXPECT_EQ(parse_test_list_line("zlib_aaa:250:inf", line), TestListLine::SyntaxError);
+    EXPECT_EQ(parse_test_list_line("zlib_aaa:250:1:2", line), TestListLine::SyntaxError);
+}
@@ -0,0 +1,43 @@
+/*
+ * Copyright 2025 Intel Corporation.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "weighted_test_scheduler.h"
+
+#include <algorithm>
+
+static bool is_eligible(const WeightedTestScheduler::Candidate &c, ShortDuration remaining)
+{
+    return c.weight > 0 && c.duration <= remaining;
+}
+
+int WeightedTestScheduler::next(ShortDuration remaining)
+{
+    int best = -1;
+    double best_score = 0;
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        const Candidate &c = candidates[i];
+        if (!is_eligible(c, remaining))
+            continue;
+
+        // a zero-length run costs at least a millisecond
+        double cost = std::max(c.duration.count(), 1) * double(c.runs + 1);
+        double score = c.weight / cost;
+        if (score > best_score) {
+            best = i;
+            best_score = score;
+        }
+    }
+
+    if (best >= 0)
+        ++candidates[best].runs;
+    return best;
+}
+
+bool WeightedTestScheduler::fits(ShortDuration remaining) const
+{
+    return std::any_of(candidates.begin(), candidates.end(), [=](const Candidate &c) {
+        return is_eligible(c, remaining);
+    });
+}
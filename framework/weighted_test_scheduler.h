@@ -0,0 +1,62 @@
+/*
+ * Copyright 2025 Intel Corporation.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef SANDSTONE_WEIGHTED_TEST_SCHEDULER_H
+#define SANDSTONE_WEIGHTED_TEST_SCHEDULER_H
+
+#include "sandstone_chrono.h"
+
+#include <vector>
+
+/*
+ * Picks which test to run next out of a fixed list, given each test's weight
+ * (its relative value in finding defects) and its run duration.
+ *
+ * Each pick goes to the test with the largest
+ *
+ *      weight / ((runs + 1) * duration)
+ *
+ * that still fits in the remaining time budget. That is the test whose next
+ * run adds the most expected coverage per CPU-second, assuming each repeated
+ * run of the same test is worth less than the previous one (the value of
+ * running a test n times grows like weight * log(n)). Over a long run, each
+ * test ends up with a share of the time proportional to its weight. A weight
+ * of zero means the test is never picked. Ties go to the earlier test in the
+ * list, so the schedule is deterministic.
+ */
+class WeightedTestScheduler
+{
+public:
+    struct Candidate
+    {
+        double weight = 1.0;
+        ShortDuration duration = {};
+        int runs = 0;
+    };
+
+    WeightedTestScheduler() = default;
+    explicit WeightedTestScheduler(std::vector<Candidate> candidates)
+        : candidates(std::move(candidates))
+    {}
+
+    // returns the index of the next test to run (and counts it as run), or -1
+    // if no test with a non-zero weight fits in the remaining time
+    int next(ShortDuration remaining);
+
+    // whether any test could still be picked with this much time left
+    bool fits(ShortDuration remaining) const;
+
+    // stops picking this test (for example, because it skipped)
+    void drop(int idx)
+    { candidates.at(idx).weight = 0; }
+
+    const std::vector<Candidate> &entries() const
+    { return candidates; }
+
+private:
+    std::vector<Candidate> candidates;
+};
+
+#endif // SANDSTONE_WEIGHTED_TEST_SCHEDULER_H
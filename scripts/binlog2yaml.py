@@ -0,0 +1,302 @@
+#!/usr/bin/env python3
+# Copyright 2025 Intel Corporation.
+# SPDX-License-Identifier: Apache-2.0
+
+# Converts the file written by opendcdiag --binary-log=<file> into the
+# per-test YAML (default) or TAP output that opendcdiag would have written
+# to its log. The format is described in framework/logging.cpp (namespace
+# BinaryLog); keep the two in sync.
+
+# Usage:
+# ./binlog2yaml.py [--tap] binary-log-file > output
+
+import argparse
+import math
+import struct
+import sys
+
+MAGIC = b'SDCDBLOG'
+VERSION = 1
+
+FILE_HEADER = struct.Struct('<8sII')
+CPU = struct.Struct('<QQihhhhhHBB6x')
+RECORD = struct.Struct('<IB3xiIq')
+THREAD_INFO = struct.Struct('<qQQd')
+
+TEST_RECORD = 1
+THREAD_RECORD = 2
+
+# message types and levels, see message_code() in framework/logging.cpp
+USER_MESSAGES, PREFORMATTED, USED_KNOB_VALUE, SKIP_MESSAGES = range(4)
+LEVELS = ('error', 'warning', 'info', 'debug')
+
+SKIP_CATEGORIES = {
+    1: 'CpuNotSupported',
+    2: 'CpuTopologyIssue',
+    3: 'TestResourceIssue',
+    4: 'OSResourceIssue',
+    5: 'OsNotSupported',
+    6: 'DeviceNotFound',
+    7: 'DeviceNotConfigured',
+    8: 'Unknown',
+    9: 'IgnoredMceCategory',
+    10: 'Runtime',
+    11: 'TestObsolete',
+    12: 'Selftest',
+}
+
+
+class Cpu:
+    def __init__(self, fields):
+        (self.microcode, self.ppin, self.cpu_number, self.package_id, self.numa_id,
+         self.module_id, self.core_id, self.thread_id, self.model, self.family,
+         self.stepping) = fields
+
+
+class Thread:
+    def __init__(self, thread, info, payload):
+        self.thread = thread
+        (self.time_to_fail_ns, self.loop_count_at_fail, self.loop_count,
+         self.freq_mhz) = info
+        self.messages = []
+        for raw in payload.split(b'\0')[:-1]:
+            if not raw:
+                continue
+            code = raw[0]
+            text = raw[1:].decode('utf-8', errors='replace')
+            self.messages.append(((code >> 4) - 1, code & 0xf, text))
+
+    def failed(self):
+        return self.time_to_fail_ns >= 0
+
+
+class Test:
+    def __init__(self, number, test_id, result):
+        self.number = number
+        self.id = test_id
+        self.result = result
+        self.threads = []
+
+
+def read_log(f):
+    data = f.read()
+    magic, version, cpu_count = FILE_HEADER.unpack_from(data, 0)
+    if magic != MAGIC:
+        sys.exit('not an opendcdiag binary log')
+    if version != VERSION:
+        sys.exit(f'unsupported binary log version {version}')
+
+    offset = FILE_HEADER.size
+    cpus = []
+    for _ in range(cpu_count):
+        cpus.append(Cpu(CPU.unpack_from(data, offset)))
+        offset += CPU.size
+
+    tests = []
+    while offset + RECORD.size <= len(data):
+        size, rtype, thread, test_count, _timestamp = RECORD.unpack_from(data, offset)
+        offset += RECORD.size
+        payload = data[offset:offset + size]
+        offset += size
+
+        if rtype == TEST_RECORD:
+            test_id, result = payload.split(b'\0')[:2]
+            tests.append(Test(test_count, test_id.decode(), result.decode()))
+        elif rtype == THREAD_RECORD and tests:
+            info = THREAD_INFO.unpack_from(payload, 0)
+            tests[-1].threads.append(Thread(thread, info, payload[THREAD_INFO.size:]))
+    return cpus, tests
+
+
+def format_duration(ns):
+    # same as format_duration() in framework/sandstone_chrono.cpp
+    us = ns // 1000
+    return f'{us // 1000}.{us % 1000:03d}'
+
+
+def single_line(text):
+    return text.replace("'", "''")
+
+
+def indented(indent, text):
+    return ''.join(f'{indent}{line}\n' for line in text.split('\n'))
+
+
+def main_skip_message(test):
+    for t in test.threads:
+        if t.thread >= 0:
+            continue
+        for mtype, _, text in t.messages:
+            if mtype == SKIP_MESSAGES:
+                return text
+    return None
+
+
+def thread_messages(test, t):
+    # the skip message of a main thread goes in the result lines instead
+    skip_in_main = test.result == 'skip' and main_skip_message(test) is not None
+    for mtype, level, text in t.messages:
+        if mtype == USED_KNOB_VALUE:
+            continue
+        if mtype == SKIP_MESSAGES and (skip_in_main and t.thread < 0):
+            continue
+        yield mtype, level, text
+
+
+def yaml_thread_id(cpu):
+    line = (f'{{ logical: {cpu.cpu_number}, package: {cpu.package_id}, '
+            f'numa_node: {cpu.numa_id}, module: {cpu.module_id}, core: {cpu.core_id}, '
+            f'thread: {cpu.thread_id}, family: {cpu.family}, model: {cpu.model:#x}, '
+            f'stepping: {cpu.stepping}, microcode: ')
+    line += f'{cpu.microcode:#x}' if cpu.microcode else 'null'
+    line += ', ppin: '
+    line += f'"{cpu.ppin:016x}"' if cpu.ppin else 'null'
+    return line + ' }'
+
+
+def print_yaml(cpus, tests, out):
+    out.write('tests:\n')
+    for test in tests:
+        out.write(f'- test: {test.id}\n')
+        out.write(f'  result: {test.result}\n')
+        if test.result == 'skip':
+            message = main_skip_message(test)
+            if message is None:
+                out.write('  skip-category: Runtime\n')
+                out.write("  skip-reason: All CPUs skipped while executing 'test_run()' "
+                          'function, check log for details\n')
+            else:
+                out.write(f'  skip-category: {SKIP_CATEGORIES.get(ord(message[0]), "NO CATEGORY PRESENT")}\n')
+                if '\n' in message[1:]:
+                    out.write('  skip-reason: |1\n')
+                    out.write(indented('   ', message[1:]))
+                else:
+                    out.write(f"  skip-reason: '{single_line(message[1:])}'\n")
+
+        knobs = {}
+        for t in test.threads:
+            for mtype, _, text in t.messages:
+                if mtype == USED_KNOB_VALUE:
+                    knobs.setdefault(text.split(':', 1)[0], text)
+        if knobs:
+            out.write('  test-options:\n')
+            for text in knobs.values():
+                out.write(f'    {text}\n')
+
+        threads_header = False
+        for t in test.threads:
+            messages = list(thread_messages(test, t))
+            if not messages and t.thread < 0:
+                continue
+            if not threads_header:
+                out.write('  threads:\n')
+                threads_header = True
+
+            if t.thread < 0:
+                slice_number = ~t.thread
+                out.write('  - thread: main\n' if slice_number == 0 else f'  - thread: main {slice_number}\n')
+            else:
+                out.write(f'  - thread: {t.thread}\n')
+                if t.thread < len(cpus):
+                    out.write(f'    id: {yaml_thread_id(cpus[t.thread])}\n')
+                if t.failed():
+                    out.write('    state: failed\n')
+                    out.write(f'    time-to-fail: {format_duration(t.time_to_fail_ns)}\n')
+                    out.write(f'    loop-count: {t.loop_count_at_fail}\n')
+                else:
+                    out.write(f'    loop-count: {t.loop_count}\n')
+                if math.isfinite(t.freq_mhz):
+                    out.write(f'    freq_mhz: {t.freq_mhz:.1f}\n')
+
+            out.write('    messages:\n')
+            for mtype, level, text in messages:
+                if mtype == PREFORMATTED:
+                    out.write(text)
+                    continue
+                if mtype == SKIP_MESSAGES:
+                    level_name, text = 'skip', text[1:]
+                else:
+                    level_name = LEVELS[level] if level < len(LEVELS) else str(level)
+                if '\n' in text:
+                    if text.endswith('\n'):
+                        text = text[:-1]
+                    out.write(f'    - level: {level_name}\n')
+                    out.write('      text: |1\n')
+                    out.write(indented('       ', text))
+                else:
+                    out.write(f"    - {{ level: {level_name}, text: '{single_line(text)}' }}\n")
+
+
+def print_tap(cpus, tests, out):
+    suffixes = {
+        'skip': 'SKIP',
+        'timed out': 'timed out',
+        'crash': 'Killed',
+        'interrupted': 'Interrupted',
+        'operating system error': 'Operating system error',
+    }
+    for test in tests:
+        ok = 'ok' if test.result in ('pass', 'skip') else 'not ok'
+        line = f'{ok} {test.number:3d} {test.id}'
+        if test.result in suffixes:
+            line = f'{line:<32} # {suffixes[test.result]}'
+        out.write(line + '\n')
+
+        marker = False
+        for t in test.threads:
+            messages = list(thread_messages(test, t))
+            if not messages and t.thread < 0:
+                continue
+            if not marker:
+                out.write(' ---\n')
+                marker = True
+
+            if t.thread < 0:
+                slice_number = ~t.thread
+                out.write('  Main thread:\n' if slice_number == 0 else f'  Main thread {slice_number}:\n')
+            else:
+                cpu = cpus[t.thread] if t.thread < len(cpus) else None
+                if cpu:
+                    microcode = f'{cpu.microcode:#x}' if cpu.microcode else 'N/A'
+                    ppin = f'{cpu.ppin:016x}' if cpu.ppin else 'N/A'
+                    out.write(f'  Thread {t.thread} on CPU {cpu.cpu_number} (pkg {cpu.package_id}, '
+                              f'core {cpu.core_id}, thr {cpu.thread_id}, family/model/stepping '
+                              f'{cpu.family:02x}-{cpu.model:02x}-{cpu.stepping:02x}, '
+                              f'microcode {microcode}, PPIN {ppin}):\n')
+                else:
+                    out.write(f'  Thread {t.thread}:\n')
+                if t.failed():
+                    out.write(f'  - failed: {{ time: {format_duration(t.time_to_fail_ns)}, '
+                              f'loop-count: {t.loop_count_at_fail} }}\n')
+
+            for mtype, _, text in messages:
+                if mtype == PREFORMATTED:
+                    out.write(text)
+                    continue
+                if mtype == SKIP_MESSAGES:
+                    text = text[1:]
+                if '\n' in text:
+                    out.write('  - |\n')
+                    out.write(indented('    ', text))
+                else:
+                    out.write(f"   - '{single_line(text)}'\n")
+        if marker:
+            out.write(' ---\n')
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Convert an opendcdiag binary log to YAML or TAP')
+    parser.add_argument('--tap', action='store_true', help='produce TAP output instead of YAML')
+    parser.add_argument('file', help='file written by opendcdiag --binary-log')
+    args = parser.parse_args()
+
+    with open(args.file, 'rb') as f:
+        cpus, tests = read_log(f)
+    if args.tap:
+        print_tap(cpus, tests, sys.stdout)
+    else:
+        print_yaml(cpus, tests, sys.stdout)
+
+
+if __name__ == '__main__':
+    main()
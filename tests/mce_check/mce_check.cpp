@@ -39,7 +39,9 @@ static int mce_check_run(struct test *test, int cpu)
     if (cpu != 0)
         return EXIT_SUCCESS;
 
-    std::vector<uint32_t> counts = sApp->get_mce_interrupt_counts();
+    // one read of the interrupt table for both the MCE and the thermal counts
+    InterruptMonitor::InterruptCounts all_counts = sApp->sample_interrupt_counts();
+    std::vector<uint32_t> &counts = all_counts.mce;
 
     if (counts.size() != sApp->mce_counts_start.size()) {
         report_fail_msg("Number of CPUs changed during execution, test is not valid.");
@@ -80,7 +82,7 @@ static int mce_check_run(struct test *test, int cpu)
     if (errorcount)
         log_platform_message(SANDSTONE_LOG_ERROR "MCE interrupts detected on %d CPUs", errorcount);
 
-    uint64_t thermal_now = sApp->count_thermal_events();
+    uint64_t thermal_now = std::accumulate(all_counts.thermal.begin(), all_counts.thermal.end(), uint64_t(0));
     if (thermal_now != sApp->last_thermal_event_count) {
         log_platform_message(SANDSTONE_LOG_WARNING "Thermal events detected (%zu since start).",
                              size_t(thermal_now - sApp->last_thermal_event_count));
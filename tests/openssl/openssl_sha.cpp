@@ -36,61 +36,108 @@ struct sha_elem
     uint8_t sha512sum[SHA512_DIGEST_LENGTH];
 };
 
+enum ShaAlgorithm {
+    Sha256,
+    Sha384,
+    Sha512,
+    ShaAlgorithmCount
+};
+
 struct sha_test
 {
     uint8_t *arena;
-    uint8_t arena_size;
+    size_t arena_size;
     sha_elem golden_elements[SHA_GOLDEN_ELEMS];
 };
 
-static void ssl_sha256(sha_elem *target)
+/* digests and contexts are fetched / allocated once per thread and reused */
+struct sha_context
 {
-    /* Create Context */
-    EVP_MD_CTX *mdctx = s_EVP_MD_CTX_new();
+    EVP_MD *md[ShaAlgorithmCount];
+    EVP_MD_CTX *mdctx;
+};
 
-    /* Fetch algorithm */
-    const EVP_MD *md = s_EVP_get_digestbyname("sha256");
+static uint8_t *sha_digest(sha_elem *elem, ShaAlgorithm alg)
+{
+    switch (alg) {
+    case Sha256:
+        return &elem->sha256sum[0];
+    case Sha384:
+        return &elem->sha384sum[0];
+    case Sha512:
+    case ShaAlgorithmCount:
+        break;
+    }
+    return &elem->sha512sum[0];
+}
 
-    /* Digest */
-    unsigned int md_len = 0;
-    s_EVP_DigestInit_ex(mdctx, md, NULL);
-    s_EVP_DigestUpdate(mdctx, &target->plain_text[0], PLAINTEXT_SIZE);
-    s_EVP_DigestFinal_ex(mdctx, &target->sha256sum[0], &md_len);
+static void sha_context_cleanup(sha_context *ctx)
+{
+    s_EVP_MD_CTX_free(ctx->mdctx);
+    ctx->mdctx = nullptr;
+    for (EVP_MD *&md : ctx->md) {
+        s_EVP_MD_free(md);
+        md = nullptr;
+    }
 }
 
-static void ssl_sha384(sha_elem *target)
+static bool sha_context_init(sha_context *ctx)
 {
-    /* Create Context */
-    EVP_MD_CTX *mdctx = s_EVP_MD_CTX_new();
+    static const char *const names[ShaAlgorithmCount] = { "SHA256", "SHA384", "SHA512" };
 
-    /* Fetch algorithm */
-    const EVP_MD *md = s_EVP_get_digestbyname("sha384");
+    memset(ctx, 0, sizeof(*ctx));
+    for (int alg = 0; alg < ShaAlgorithmCount; ++alg) {
+        ctx->md[alg] = s_EVP_MD_fetch(nullptr, names[alg], nullptr);
+        if (!ctx->md[alg])
+            goto fail;
+    }
+    ctx->mdctx = s_EVP_MD_CTX_new();
+    if (!ctx->mdctx)
+        goto fail;
+    return true;
+
+fail:
+    sha_context_cleanup(ctx);
+    return false;
+}
 
-    /* Digest */
+static void ssl_sha(sha_context *ctx, sha_elem *target, ShaAlgorithm alg)
+{
+    EVP_MD_CTX *mdctx = ctx->mdctx;
     unsigned int md_len = 0;
-    s_EVP_DigestInit_ex(mdctx, md, NULL);
+    s_EVP_DigestInit_ex2(mdctx, ctx->md[alg], nullptr);
     s_EVP_DigestUpdate(mdctx, &target->plain_text[0], PLAINTEXT_SIZE);
-    s_EVP_DigestFinal_ex(mdctx, &target->sha384sum[0], &md_len);
+    s_EVP_DigestFinal_ex(mdctx, sha_digest(target, alg), &md_len);
 }
 
-static void ssl_sha512(sha_elem *target)
+static void ssl_sha_all(sha_context *ctx, sha_elem *target)
 {
-    /* Create Context */
-    EVP_MD_CTX *mdctx = s_EVP_MD_CTX_new();
-
-    /* Fetch algorithm */
-    const EVP_MD *md = s_EVP_get_digestbyname("sha512");
+    ssl_sha(ctx, target, Sha256);
+    ssl_sha(ctx, target, Sha384);
+    ssl_sha(ctx, target, Sha512);
+}
 
-    /* Digest */
-    unsigned int md_len = 0;
-    s_EVP_DigestInit_ex(mdctx, md, NULL);
-    s_EVP_DigestUpdate(mdctx, &target->plain_text[0], PLAINTEXT_SIZE);
-    s_EVP_DigestFinal_ex(mdctx, &target->sha512sum[0], &md_len);
+static void ssl_sha_compare(sha_elem *our_elem, const sha_elem *golden_elem)
+{
+    /* Check result against golden values */
+    memcmp_or_fail(&our_elem->sha256sum[0], &golden_elem->sha256sum[0], SHA256_DIGEST_LENGTH,
+            "sha256sum values does not match.");
+    memcmp_or_fail(&our_elem->sha384sum[0], &golden_elem->sha384sum[0], SHA384_DIGEST_LENGTH,
+            "sha384sum values does not match.");
+    memcmp_or_fail(&our_elem->sha512sum[0], &golden_elem->sha512sum[0], SHA512_DIGEST_LENGTH,
+            "sha512sum values does not match.");
 }
 
 static int ssl_sha_init(struct test* test)
 {
-    if (s_EVP_DigestInit_ex && s_EVP_DigestUpdate && s_EVP_DigestFinal_ex && s_EVP_get_digestbyname) {
+    if (s_EVP_MD_fetch && s_EVP_MD_free && s_EVP_MD_CTX_new && s_EVP_MD_CTX_free &&
+            s_EVP_DigestInit_ex2 && s_EVP_DigestUpdate && s_EVP_DigestFinal_ex) {
+        sha_context ctx;
+        if (!sha_context_init(&ctx)) {
+            log_skip(TestResourceIssueSkipCategory, "OpenSSL could not provide the SHA-2 digests");
+            return EXIT_SKIP;
+        }
+
         const size_t sha_offset = (random64() & 0x1ff) | 1;
         const size_t sha_arena_size = sha_offset + sizeof(sha_test);
         uint8_t *sha_arena = (uint8_t *) mmap(NULL, sha_arena_size, PROT_READ|PROT_WRITE, MAP_ANONYMOUS|MAP_PRIVATE, -1, 0);
@@ -107,11 +154,10 @@ static int ssl_sha_init(struct test* test)
             memset_random(&cursor->plain_text[0], PLAINTEXT_SIZE);
 
             /* Calculate sha checksums */
-            ssl_sha256(cursor);
-            ssl_sha384(cursor);
-            ssl_sha512(cursor);
+            ssl_sha_all(&ctx, cursor);
         }
 
+        sha_context_cleanup(&ctx);
         return EXIT_SUCCESS;
     }
     else {
@@ -120,11 +166,22 @@ static int ssl_sha_init(struct test* test)
     }
 }
 
+static int ssl_sha_cleanup(struct test *test)
+{
+    if (sha_test *sha_test_ptr = (sha_test *) test->data)
+        munmap(sha_test_ptr->arena, sha_test_ptr->arena_size);
+    return EXIT_SUCCESS;
+}
+
 static int ssl_sha_run(struct test* test, int cpu)
 {
     sha_test *sha_test_ptr = (sha_test *) test->data;
     sha_elem *golden_elements = &sha_test_ptr->golden_elements[0];
 
+    sha_context ctx;
+    if (!sha_context_init(&ctx))
+        report_fail_msg("OpenSSL failed to provide the SHA-2 digests");
+
     const size_t our_arena_size = SHA_MAX_OFFSET + sizeof(sha_elem);
     uint8_t *our_arena = (uint8_t *) mmap(NULL, our_arena_size, PROT_READ|PROT_WRITE, MAP_ANONYMOUS|MAP_PRIVATE, -1, 0);
 
@@ -138,18 +195,12 @@ static int ssl_sha_run(struct test* test, int cpu)
         memcpy(&our_elem->plain_text, &golden_elem->plain_text[0], PLAINTEXT_SIZE);
 
         /* Calculate sha checksums */
-        ssl_sha256(our_elem);
-        ssl_sha384(our_elem);
-        ssl_sha512(our_elem);
-
-        /* Check result against golden values */
-        memcmp_or_fail(&our_elem->sha256sum[0], &golden_elem->sha256sum[0], SHA256_DIGEST_LENGTH,
-                "sha256sum values does not match.");
-        memcmp_or_fail(&our_elem->sha384sum[0], &golden_elem->sha384sum[0], SHA384_DIGEST_LENGTH,
-                "sha384sum values does not match.");
-        memcmp_or_fail(&our_elem->sha512sum[0], &golden_elem->sha512sum[0], SHA512_DIGEST_LENGTH,
-                "sha512sum values does not match.");
+        ssl_sha_all(&ctx, our_elem);
+        ssl_sha_compare(our_elem, golden_elem);
     }
+
+    munmap(our_arena, our_arena_size);
+    sha_context_cleanup(&ctx);
     return EXIT_SUCCESS;
 }
 
@@ -166,10 +217,16 @@ static int ssl_sha_run(struct test *test, int cpu)
     __builtin_unreachable();
 }
 
+static int ssl_sha_cleanup(struct test *test)
+{
+    return EXIT_SUCCESS;
+}
+
 #endif
 
 DECLARE_TEST(openssl_sha, "Test calculating different sha checksums")
     .test_init = ssl_sha_init,
     .test_run = ssl_sha_run,
+    .test_cleanup = ssl_sha_cleanup,
     .quality_level = TEST_QUALITY_PROD,
 END_DECLARE_TEST
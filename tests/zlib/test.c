@@ -21,6 +21,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 #include <sandstone.h>
@@ -32,7 +33,17 @@
 struct zlib_parameters
 {
     int level;
-    unsigned maxbuffersize;
+    unsigned maxbuffersize : 31;
+    unsigned reuse_context : 1;     // 0 = set up streams and buffers on every iteration
+};
+
+struct zlib_context
+{
+    z_stream deflate_strm;
+    z_stream inflate_strm;
+    uint8_t *buf, *out, *back;
+    int level;
+    bool reuse;
 };
 
 static void __attribute__((cold, noreturn)) print_zlib_error(const char *func, int status)
@@ -46,75 +57,124 @@ static void __attribute__((cold, noreturn)) print_zlib_error(const char *func, i
     report_fail_msg("%s failed: %s (%d)", func, err_str, status);
 }
 
-static void zlib_gen_buffer(size_t *bufsz, uint8_t ** buf, unsigned maxbuffersize)
+static void zlib_deflate_init(z_stream *strm, int level)
 {
-    *bufsz = (random32() % maxbuffersize) + 4096;
+    memset(strm, 0, sizeof(*strm));
+    int status = deflateInit2(strm, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+    if (status != Z_OK)
+        print_zlib_error("deflateInit2", status);
+}
 
-    *buf = malloc(*bufsz + 16);
-    memset_random(*buf, *bufsz);
+static void zlib_inflate_init(z_stream *strm)
+{
+    memset(strm, 0, sizeof(*strm));
+    int status = inflateInit2(strm, 15 + 16);
+    if (status != Z_OK)
+        print_zlib_error("inflateInit2", status);
 }
 
-static void zcheck(size_t bufsz, uint8_t * buf, int level)
+/*
+ * Unless the reuse_context knob is 0, each thread initializes its streams and
+ * allocates its buffers (sized for the largest input) once, before the test
+ * loop, and only resets the streams on each iteration. That way, the loop
+ * spends its time compressing instead of in the allocator and in zlib's
+ * state setup.
+ */
+static void zlib_context_init(struct zlib_context *ctx, const struct zlib_parameters *p, size_t maxbufsz)
 {
-    int status;
-    uint8_t *out, *back;
-    size_t csize;
-    z_stream strm;
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->level = p->level;
+    ctx->reuse = p->reuse_context;
+    if (!ctx->reuse)
+        return;
+
+    ctx->buf = malloc(maxbufsz + 16);
+    ctx->out = malloc(maxbufsz * 2);
+    ctx->back = malloc(maxbufsz);
+    zlib_deflate_init(&ctx->deflate_strm, ctx->level);
+    zlib_inflate_init(&ctx->inflate_strm);
+}
 
-    out = malloc(bufsz * 2);
-    back = malloc(bufsz);
-    memset(&strm, 0, sizeof(strm));
+static void zlib_context_cleanup(struct zlib_context *ctx)
+{
+    if (!ctx->reuse)
+        return;
+    inflateEnd(&ctx->inflate_strm);
+    deflateEnd(&ctx->deflate_strm);
+    free(ctx->back);
+    free(ctx->out);
+    free(ctx->buf);
+}
 
-    status = deflateInit2(&strm, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
-    if (status != Z_OK)
-        print_zlib_error("deflateInit2", status);
+static size_t zlib_gen_buffer(struct zlib_context *ctx, uint8_t **buf, unsigned maxbuffersize)
+{
+    size_t bufsz = (random32() % maxbuffersize) + 4096;
 
-    strm.next_in = buf;
-    strm.avail_in = bufsz;
-    strm.next_out = out;
-    strm.avail_out = bufsz * 2;
+    *buf = ctx->reuse ? ctx->buf : malloc(bufsz + 16);
+    memset_random(*buf, bufsz);
+    return bufsz;
+}
+
+static void zcheck(struct zlib_context *ctx, size_t bufsz, uint8_t * buf)
+{
+    int status;
+    uint8_t *out = ctx->out, *back = ctx->back;
+    size_t csize;
+    z_stream *strm;
+
+    if (ctx->reuse) {
+        status = deflateReset(&ctx->deflate_strm);
+        if (status != Z_OK)
+            print_zlib_error("deflateReset", status);
+        status = inflateReset(&ctx->inflate_strm);
+        if (status != Z_OK)
+            print_zlib_error("inflateReset", status);
+    } else {
+        out = malloc(bufsz * 2);
+        back = malloc(bufsz);
+        zlib_deflate_init(&ctx->deflate_strm, ctx->level);
+    }
+
+    strm = &ctx->deflate_strm;
+    strm->next_in = buf;
+    strm->avail_in = bufsz;
+    strm->next_out = out;
+    strm->avail_out = bufsz * 2;
 
     do {
-        status = deflate(&strm, Z_FINISH);
+        status = deflate(strm, Z_FINISH);
         if (status == Z_STREAM_ERROR || status == Z_BUF_ERROR) {
             print_zlib_error("deflate", status);
         }
     } while (status != Z_STREAM_END);
 
-    deflateEnd(&strm);
-
-    csize = (bufsz * 2) - strm.avail_out;
-
-    memset(&strm, 0, sizeof(strm));
-
-    strm.zalloc = Z_NULL;
-    strm.zfree = Z_NULL;
-    strm.opaque = Z_NULL;
-
-    strm.avail_in = csize;
-    strm.next_in = out;
-    strm.next_out = back;
-    strm.avail_out = bufsz;
-
-    status = inflateInit2(&strm, 15 + 16);
-    if (status != Z_OK) {
-        print_zlib_error("inflateInit2", status);
+    csize = (bufsz * 2) - strm->avail_out;
+    if (!ctx->reuse) {
+        deflateEnd(strm);
+        zlib_inflate_init(&ctx->inflate_strm);
     }
 
+    strm = &ctx->inflate_strm;
+    strm->avail_in = csize;
+    strm->next_in = out;
+    strm->next_out = back;
+    strm->avail_out = bufsz;
+
     do {
-        status = inflate(&strm, Z_FINISH);
+        status = inflate(strm, Z_FINISH);
         if (status == Z_NEED_DICT || status == Z_DATA_ERROR ||
             status == Z_MEM_ERROR || status == Z_STREAM_ERROR) {
             print_zlib_error("inflate", status);
         }
     } while (status != Z_STREAM_END);
 
-    inflateEnd(&strm);
-
     memcmp_or_fail(back, buf, bufsz, "decompressed data");
 
-    free(back);
-    free(out);
+    if (!ctx->reuse) {
+        inflateEnd(strm);
+        free(back);
+        free(out);
+    }
 }
 
 static int zlib_init_common(struct test *test, int level)
@@ -125,7 +185,8 @@ static int zlib_init_common(struct test *test, int level)
 
     struct zlib_parameters p = {
         .level = level,
-        .maxbuffersize = get_testspecific_knob_value_uint(test, "maxbuffersize", BUF_MAX)
+        .maxbuffersize = get_testspecific_knob_value_uint(test, "maxbuffersize", BUF_MAX),
+        .reuse_context = get_testspecific_knob_value_uint(test, "reuse_context", 1) != 0,
     };
     static_assert(sizeof(p) == sizeof(test->data),
         "Internal assumption broken: change me to allocate memory instead");
@@ -136,17 +197,21 @@ static int zlib_init_common(struct test *test, int level)
 static int zlib_run_common(struct test *test, int cpu)
 {
     struct zlib_parameters p;
+    struct zlib_context ctx;
     memcpy(&p, &test->data, sizeof(p));
+    zlib_context_init(&ctx, &p, p.maxbuffersize + 4096);
 
     TEST_LOOP(test, 1) {
         uint8_t *buf;
         size_t bufsz;
 
-        zlib_gen_buffer(&bufsz, &buf, p.maxbuffersize);
-        zcheck(bufsz, buf, p.level);
-        free(buf);
+        bufsz = zlib_gen_buffer(&ctx, &buf, p.maxbuffersize);
+        zcheck(&ctx, bufsz, buf);
+        if (!ctx.reuse)
+            free(buf);
     }
 
+    zlib_context_cleanup(&ctx);
     return EXIT_SUCCESS;
 }
 
@@ -173,19 +238,29 @@ static int zlib_aaa_init(struct test *test)
 static int zlib_aaa_run(struct test *test, int cpu)
 {
     struct zlib_parameters p;
+    struct zlib_context ctx;
     memcpy(&p, &test->data, sizeof(p));
+    zlib_context_init(&ctx, &p, p.maxbuffersize);
+
+    // the input never changes, so fill the reusable buffer only once
+    if (ctx.reuse)
+        memset(ctx.buf, 'a', p.maxbuffersize);
 
     TEST_LOOP(test, 1) {
-        uint8_t *buf;
+        uint8_t *buf = ctx.buf;
 
-        buf = malloc(p.maxbuffersize);
-        memset(buf, 'a', p.maxbuffersize);
+        if (!ctx.reuse) {
+            buf = malloc(p.maxbuffersize);
+            memset(buf, 'a', p.maxbuffersize);
+        }
 
-        zcheck(BUF_MAX, buf, p.level);
+        zcheck(&ctx, p.maxbuffersize, buf);
 
-        free(buf);
+        if (!ctx.reuse)
+            free(buf);
     }
 
+    zlib_context_cleanup(&ctx);
     return EXIT_SUCCESS;
 }
 
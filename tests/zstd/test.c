@@ -18,6 +18,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 #include <sandstone.h>
@@ -35,16 +36,18 @@
 struct zstd_parameters
 {
     int compression;
-    unsigned maxbuffersize;
+    unsigned maxbuffersize : 31;
+    unsigned reuse_context : 1;     // 0 = create contexts and buffers on every iteration
 };
 
-static void zstd_gen_buffer(size_t *bufsz, uint8_t ** buf, unsigned max)
+struct zstd_context
 {
-    *bufsz = (random32() % max) + 4096;
-
-    *buf = malloc(*bufsz + 16);
-    memset_random(*buf, *bufsz);
-}
+    ZSTD_CCtx *cctx;
+    ZSTD_DCtx *dctx;
+    uint8_t *buf, *comp_buf, *back_buf;
+    int level;
+    bool reuse;
+};
 
 static void __attribute__((cold, noreturn)) zstd_report_fail(const char *name, size_t errc)
 {
@@ -56,21 +59,74 @@ static void __attribute__((cold, noreturn)) zstd_report_fail(const char *name, s
     report_fail_msg("%s failed: %d (%s)", name, code, ZSTD_getErrorString(code));
 }
 
-static void zstd_check(size_t bufsz, uint8_t * buf, int level)
+/*
+ * Unless the reuse_context knob is 0, each thread creates its compression and
+ * decompression contexts and allocates its buffers (sized for the largest
+ * input) once, before the test loop. ZSTD_compressCCtx() and
+ * ZSTD_decompressDCtx() reset the contexts but keep their internal tables, so
+ * the loop spends its time compressing instead of in the allocator.
+ */
+static void zstd_context_init(struct zstd_context *ctx, const struct zstd_parameters *p, size_t maxbufsz)
+{
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->level = p->compression;
+    ctx->reuse = p->reuse_context;
+    if (!ctx->reuse)
+        return;
+
+    ctx->cctx = ZSTD_createCCtx();
+    ctx->dctx = ZSTD_createDCtx();
+    if (!ctx->cctx || !ctx->dctx)
+        report_fail_msg("failed to create the ZStandard contexts");
+    ctx->buf = malloc(maxbufsz + 16);
+    ctx->comp_buf = malloc(ZSTD_compressBound(maxbufsz));
+    ctx->back_buf = malloc(maxbufsz);
+}
+
+static void zstd_context_cleanup(struct zstd_context *ctx)
+{
+    if (!ctx->reuse)
+        return;
+    free(ctx->back_buf);
+    free(ctx->comp_buf);
+    free(ctx->buf);
+    ZSTD_freeDCtx(ctx->dctx);
+    ZSTD_freeCCtx(ctx->cctx);
+}
+
+static size_t zstd_gen_buffer(struct zstd_context *ctx, uint8_t **buf, unsigned max)
+{
+    size_t bufsz = (random32() % max) + 4096;
+
+    *buf = ctx->reuse ? ctx->buf : malloc(bufsz + 16);
+    memset_random(*buf, bufsz);
+    return bufsz;
+}
+
+static void zstd_check(struct zstd_context *ctx, size_t bufsz, uint8_t * buf)
 {
     uint8_t *comp_buf, *back_buf;
     size_t compsz, bnd, backsz;
 
     bnd = ZSTD_compressBound(bufsz);
 
-    comp_buf = malloc(bnd);
-    back_buf = malloc(bufsz);
-    compsz = ZSTD_compress(comp_buf, bnd, buf, bufsz, level);
+    if (ctx->reuse) {
+        comp_buf = ctx->comp_buf;
+        back_buf = ctx->back_buf;
+        compsz = ZSTD_compressCCtx(ctx->cctx, comp_buf, bnd, buf, bufsz, ctx->level);
+    } else {
+        comp_buf = malloc(bnd);
+        back_buf = malloc(bufsz);
+        compsz = ZSTD_compress(comp_buf, bnd, buf, bufsz, ctx->level);
+    }
     if (ZSTD_isError(compsz)) {
         zstd_report_fail("ZSTD_compress", compsz);
     }
 
-    backsz = ZSTD_decompress(back_buf, bufsz, comp_buf, compsz);
+    if (ctx->reuse)
+        backsz = ZSTD_decompressDCtx(ctx->dctx, back_buf, bufsz, comp_buf, compsz);
+    else
+        backsz = ZSTD_decompress(back_buf, bufsz, comp_buf, compsz);
     if (ZSTD_isError(backsz)) {
         zstd_report_fail("ZSTD_decompress", backsz);
     }
@@ -78,8 +134,10 @@ static void zstd_check(size_t bufsz, uint8_t * buf, int level)
     memcmp_or_fail(&backsz, &bufsz, 1, "decompressed data length");
     memcmp_or_fail(back_buf, buf, bufsz, "decompressed data");
 
-    free(back_buf);
-    free(comp_buf);
+    if (!ctx->reuse) {
+        free(back_buf);
+        free(comp_buf);
+    }
 }
 
 static int zstd_init_common(struct test *test, int level)
@@ -102,7 +160,11 @@ static int zstd_init_common(struct test *test, int level)
         level = get_testspecific_knob_value_int(test, "level", level);
     max = get_testspecific_knob_value_uint(test, "maxbuffersize", max);
 
-    struct zstd_parameters p = { .compression = level, .maxbuffersize = max };
+    struct zstd_parameters p = {
+        .compression = level,
+        .maxbuffersize = max,
+        .reuse_context = get_testspecific_knob_value_uint(test, "reuse_context", 1) != 0,
+    };
     static_assert(sizeof(p) == sizeof(test->data),
         "Internal assumption broken: change me to allocate memory instead");
     memcpy(&test->data, &p, sizeof(p));
@@ -112,16 +174,22 @@ static int zstd_init_common(struct test *test, int level)
 static int zstd_run_common(struct test *test, int cpu)
 {
     struct zstd_parameters p;
+    struct zstd_context ctx;
     memcpy(&p, &test->data, sizeof(p));
+    zstd_context_init(&ctx, &p, p.maxbuffersize + 4096);
+
     TEST_LOOP(test, 1) {
         uint8_t *buf;
         size_t bufsz;
 
-        zstd_gen_buffer(&bufsz, &buf, p.maxbuffersize);
-        zstd_check(bufsz, buf, p.compression);
+        bufsz = zstd_gen_buffer(&ctx, &buf, p.maxbuffersize);
+        zstd_check(&ctx, bufsz, buf);
 
-        free(buf);
+        if (!ctx.reuse)
+            free(buf);
     }
+
+    zstd_context_cleanup(&ctx);
     return EXIT_SUCCESS;
 }
 
@@ -145,7 +213,8 @@ static int zstd_aaa_init(struct test *test)
     static_assert(BUF_MAX_AAA == (unsigned)BUF_MAX_AAA, "Size doesn't fit!");
     struct zstd_parameters p = {
         .compression = get_testspecific_knob_value_int(test, "level", 19),
-        .maxbuffersize = get_testspecific_knob_value_uint(test, "maxbuffersize", BUF_MAX_AAA)
+        .maxbuffersize = get_testspecific_knob_value_uint(test, "maxbuffersize", BUF_MAX_AAA),
+        .reuse_context = get_testspecific_knob_value_uint(test, "reuse_context", 1) != 0,
     };
     memcpy(&test->data, &p, sizeof(p));
     return EXIT_SUCCESS;
@@ -154,18 +223,28 @@ static int zstd_aaa_init(struct test *test)
 static int zstd_aaa_run(struct test *test, int cpu)
 {
     struct zstd_parameters p;
+    struct zstd_context ctx;
     memcpy(&p, &test->data, sizeof(p));
+    zstd_context_init(&ctx, &p, p.maxbuffersize);
+
+    // the input never changes, so fill the reusable buffer only once
+    if (ctx.reuse)
+        memset(ctx.buf, 'a', p.maxbuffersize);
 
     TEST_LOOP(test, 1) {
-        uint8_t *buf;
+        uint8_t *buf = ctx.buf;
 
-        buf = malloc(p.maxbuffersize);
-        memset(buf, 'a', p.maxbuffersize);
-        zstd_check(p.maxbuffersize, buf, p.compression);
+        if (!ctx.reuse) {
+            buf = malloc(p.maxbuffersize);
+            memset(buf, 'a', p.maxbuffersize);
+        }
+        zstd_check(&ctx, p.maxbuffersize, buf);
 
-        free(buf);
+        if (!ctx.reuse)
+            free(buf);
     }
 
+    zstd_context_cleanup(&ctx);
     return EXIT_SUCCESS;
 }
 